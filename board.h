@@ -0,0 +1,55 @@
+#pragma once
+
+// ---------------- Pin assignments ----------------
+#define PIN_MC6845_CS     26  // Chip Select (active low)
+#define PIN_MC6845_RS     27  // Register Select (0=address, 1=data)
+#define PIN_MC6845_E      28  // Enable (active edge high->low)
+#define PIN_MC6845_RW     29  // Read/Write (0=write, 1=read)
+#define PIN_MC6845_CLK    25  // Clock output pin
+
+#define PIN_MA_BASE       0   // MA0..MA13 → GPIO0..13 (MC6845 address inputs - read only)
+#define MA_WIDTH          14
+
+#define PIN_RA_BASE       14  // RA0..RA2 → GPIO14..16 (MC6845 row address inputs - read only)
+#define RA_WIDTH          3
+
+#define PIN_DATA_BASE     17  // D0 = GPIO17 .. D7 = GPIO24 (MC6845 data bus)
+#define DATA_WIDTH        8
+
+// ---------------- System configuration ----------------
+#define SYSTEM_CLOCK_HZ       (400 * MHZ)  // 400 MHz RP2040 core
+
+// 80x25 (640x200) = 14.31818Mhz, 40x25 (320x200) = 7.15909Mhz
+#define CLOCK_FREQ_TEXT       (14.31818 * MHZ)  // Для 80x25 текстового режима
+#define CLOCK_FREQ_GRAPHICS   (7.15909 * MHZ)   // Для 40x25 и графического режима
+
+// Font partition (video_memory.h), 1 MB into flash and well clear of the firmware image
+#define FONT_FLASH_OFFSET     (1024 * 1024)
+
+// Video fetch engine: 1 = PIO capture + DMA lookup chain, no CPU work per fetch;
+// 0 = PIO capture + CPU lookup loop
+#ifndef VIDEO_FETCH_DMA
+#define VIDEO_FETCH_DMA 1
+#endif
+// The CPU loop in Cortex-M0+ assembly (video_fetch.S), a fixed cycle count per fetch;
+// 0 = the C loop around the fetch kernels. Firmware only, the host runs the C loop.
+#ifndef VIDEO_FETCH_ASM
+#define VIDEO_FETCH_ASM 0
+#endif
+#if VIDEO_FETCH_ASM && VIDEO_FETCH_DMA
+#error "VIDEO_FETCH_ASM needs VIDEO_FETCH_DMA=0"
+#endif
+
+// ISA memory window at B8000h served by the RP2040 (isa_vram.h): 1 on boards where it
+// replaces the two 6164s, a board revision with pld/isa-vram-rp2040.pld and
+// pld/isa-io-rp2040.pld in place of isa-vram.pld and isa-io.pld. MC6845 /CS and R/W are
+// strapped low there and their pins carry the PLD strobes; needs the CPU fetch loop
+// (pio0 has no room left).
+#ifndef CGA_ISA_VRAM
+#define CGA_ISA_VRAM 0
+#endif
+#if CGA_ISA_VRAM && VIDEO_FETCH_DMA
+#error "CGA_ISA_VRAM needs VIDEO_FETCH_DMA=0"
+#endif
+#define PIN_ISA_VRAMOE    PIN_MC6845_CS  // /VRAMOE from isa-vram-rp2040.pld
+#define PIN_ISA_VRAMWR    PIN_MC6845_RW  // /VRAMWR from isa-vram-rp2040.pld
@@ -0,0 +1,19 @@
+#pragma once
+
+// Firmware entry points. main() on the RP2040 is cga_setup() followed by
+// cga_poll() forever on core 0, while core 1 runs cga_video_poll() forever
+// (started by cga_setup). host/cga_sim drives the same calls against the
+// simulated board, interleaving the two cores on their virtual clocks.
+
+#include <stdint.h>
+
+void cga_setup(void);
+void cga_poll(void);
+void cga_video_poll(void);
+
+// Vertical blanks seen by core 1 since start-up, safe to read from core 0
+uint32_t cga_video_frames(void);
+// Page core 1 is scanning out, changes in vertical blank after a committed flip
+uint8_t cga_video_page(void);
+// An IN from the 3Dxh block (cga_io.h): 3DAh status at this moment, 0xFF otherwise
+uint8_t cga_io_read(uint16_t port);
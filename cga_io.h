@@ -0,0 +1,142 @@
+#pragma once
+
+// CGA I/O registers in the 3Dxh block, as isa-io.pld decodes it (CGA.md). Pure C,
+// shared by the firmware and the host tools.
+//
+//   3D4h/3D5h  MC6845 index/data, through the shadow (crtc_shadow.h)
+//   3D8h       Mode Control: a new mode switches the fetch mode and DOTCLK and loads
+//              that mode's CRTC table, as the BIOS would after it. 640x200 (HIRES)
+//              only changes what the board does with the fetched bytes. 160x100 has
+//              no bit of its own: it is 80x25 with R9 = 1, so a 3D5h write to R9
+//              moves the fetch engine between the two
+//   3D9h       Color Select: kept for the board latch, nothing in the firmware uses it
+//   3DAh       Status: display enable and vertical retrace from the raster position
+//
+// Status has no pins to come from. Its fast path is raster_status.pio: the frame as a
+// timeline of runs (cga_io_timeline_line()), played in DOTCLKs from the RA0 edge that
+// starts line 1, the status stored by DMA where a read finds it. Until that engine is
+// running on the current timings core 1 anchors a raster counter on the frame's first
+// character as the fetch engine sees it on MA/RA and readers count character clocks
+// from there on the 1 us timer; cga_io_status() turns the count into the bits the
+// MC6845 would be showing on DE and VSYNC.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "video_modes.h"
+
+#define CGA_IO_CRTC_INDEX 0x3D4
+#define CGA_IO_CRTC_DATA  0x3D5
+#define CGA_IO_MODE       0x3D8
+#define CGA_IO_COLOR      0x3D9
+#define CGA_IO_STATUS     0x3DA
+
+// Mode Control (3D8h)
+#define CGA_MODE_80COL    0x01
+#define CGA_MODE_GRAPHICS 0x02
+#define CGA_MODE_BW       0x04
+#define CGA_MODE_ENABLE   0x08
+#define CGA_MODE_HIRES    0x10 // 640x200
+#define CGA_MODE_BLINK    0x20
+
+// What the BIOS writes for modes 1, 3, 4 and 6 (the console keys use them), and what
+// a 160x100 program writes before its R4..R9: 80x25 with blink off
+#define CGA_MODE_VALUE_40x25   (CGA_MODE_BLINK | CGA_MODE_ENABLE)
+#define CGA_MODE_VALUE_80x25   (CGA_MODE_BLINK | CGA_MODE_ENABLE | CGA_MODE_80COL)
+#define CGA_MODE_VALUE_320x200 (CGA_MODE_BLINK | CGA_MODE_ENABLE | CGA_MODE_GRAPHICS)
+#define CGA_MODE_VALUE_640x200 (CGA_MODE_HIRES | CGA_MODE_ENABLE | CGA_MODE_BW | CGA_MODE_GRAPHICS)
+#define CGA_MODE_VALUE_160x100 (CGA_MODE_ENABLE | CGA_MODE_80COL)
+
+// Status (3DAh)
+#define CGA_STATUS_DISPLAY_OFF  0x01 // DE inactive: horizontal or vertical blank
+#define CGA_STATUS_PEN_TRIGGER  0x02 // No light pen: always 0
+#define CGA_STATUS_PEN_SWITCH   0x04 // No light pen: switch open
+#define CGA_STATUS_VRETRACE     0x08 // VSYNC
+#define CGA_STATUS_IDLE         CGA_STATUS_PEN_SWITCH
+
+// The fetch engine mode a Mode Control value selects; the bits that only matter to the
+// board latch (B/W, enable, blink) are ignored, and so is HIRES without GRAPHICS.
+static inline video_mode_t cga_io_video_mode(const uint8_t mode) {
+    if (mode & CGA_MODE_GRAPHICS) {
+        return mode & CGA_MODE_HIRES ? VIDEO_MODE_GRAPHICS_640 : VIDEO_MODE_GRAPHICS;
+    }
+    return mode & CGA_MODE_80COL ? VIDEO_MODE_TEXT_80x25 : VIDEO_MODE_TEXT_40x25;
+}
+
+// The fetch engine mode after `r9` is written to R9 in `mode`; false if it stays
+static inline bool cga_io_tweak_mode(const video_mode_t mode, const uint8_t r9, video_mode_t *video_mode) {
+    const bool tweak = (r9 & 0x1F) == 1;
+    if (mode == VIDEO_MODE_TEXT_80x25 && tweak) {
+        *video_mode = VIDEO_MODE_TEXT_160x100;
+    } else if (mode == VIDEO_MODE_TEXT_160x100 && !tweak) {
+        *video_mode = VIDEO_MODE_TEXT_80x25;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static inline uint32_t cga_io_frame_lines(const uint8_t r[16]) {
+    return (uint32_t) ((r[4] & 0x7F) + 1) * ((r[9] & 0x1F) + 1u) + (r[5] & 0x1F);
+}
+
+// Status for the character `chars` clocks after the first character of a frame,
+// under R0-R15 `r`; the same DE and VSYNC the MC6845 model produces (VSYNC fixed at
+// 16 scanlines from the first line of row R7)
+static inline uint8_t cga_io_status(const uint8_t r[16], const uint32_t chars) {
+    const uint32_t line_chars = (uint32_t) r[0] + 1;
+    const uint32_t row_lines = (uint32_t) (r[9] & 0x1F) + 1;
+    const uint32_t line = chars / line_chars % cga_io_frame_lines(r);
+    const uint32_t column = chars % line_chars;
+
+    uint8_t status = CGA_STATUS_IDLE;
+    if (column >= r[1] || line >= (uint32_t) (r[6] & 0x7F) * row_lines) {
+        status |= CGA_STATUS_DISPLAY_OFF;
+    }
+    if (line - (uint32_t) (r[7] & 0x7F) * row_lines < 16) {
+        status |= CGA_STATUS_VRETRACE;
+    }
+    return status;
+}
+
+// The registers cga_io_status() depends on
+static inline bool cga_io_same_timings(const uint8_t a[16], const uint8_t b[16]) {
+    return a[0] == b[0] && a[1] == b[1] && a[4] == b[4] && a[5] == b[5] && a[6] == b[6] && a[7] == b[7] &&
+           a[9] == b[9];
+}
+
+// ---------------- Status timeline (raster_status.pio) ----------------
+// One word per run: the status in bits 0..7, its length in DOTCLKs - 1 above. A frame
+// is built line by line from line 1 (the first RA0 rising edge of the frame) round to
+// line 0; runs of the same status are merged, so a line takes one or two words.
+
+#define CGA_IO_DOTCLKS_PER_CHAR 8 // character.pld divider
+#define CGA_IO_TIMELINE_RUN_MAX (1u << 24)
+
+static inline uint32_t cga_io_timeline_append(uint32_t *timeline, uint32_t words, const uint32_t max,
+                                              const uint8_t status, const uint32_t chars) {
+    const uint32_t dotclks = chars * CGA_IO_DOTCLKS_PER_CHAR;
+    if (words && (timeline[words - 1] & 0xFF) == status &&
+        (timeline[words - 1] >> 8) + 1 + dotclks <= CGA_IO_TIMELINE_RUN_MAX) {
+        timeline[words - 1] += dotclks << 8;
+        return words;
+    }
+    if (words == max) {
+        return 0;
+    }
+    timeline[words] = status | (dotclks - 1) << 8;
+    return words + 1;
+}
+
+// Append `line` of the frame; the new word count, 0 if `max` words are not enough
+static inline uint32_t cga_io_timeline_line(const uint8_t r[16], const uint32_t line, uint32_t *timeline,
+                                            const uint32_t words, const uint32_t max) {
+    const uint32_t line_chars = (uint32_t) r[0] + 1;
+    const uint32_t first = line * line_chars;
+    // DE only changes at column 0 and column R1, VSYNC at the start of a line
+    if (!r[1] || r[1] >= line_chars) {
+        return cga_io_timeline_append(timeline, words, max, cga_io_status(r, first), line_chars);
+    }
+    const uint32_t next = cga_io_timeline_append(timeline, words, max, cga_io_status(r, first), r[1]);
+    return next ? cga_io_timeline_append(timeline, next, max, cga_io_status(r, first + r[1]), line_chars - r[1]) : 0;
+}
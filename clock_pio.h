@@ -9,8 +9,9 @@
 #include <hardware/clocks.h>
 #endif
 
-#define PIO_CLOCK pio0
-#define SM_CLOCK 1
+// pio1: the video fetch engine needs all of pio0's instruction memory
+#define PIO_CLOCK pio1
+#define SM_CLOCK 0
 
 #define FREQ ((2*1100 * KHZ)) // 1.100
 
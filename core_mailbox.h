@@ -0,0 +1,63 @@
+#pragma once
+
+// Lock-free single-producer/single-consumer mailbox from core 0 to core 1.
+// Core 0 (USB console, mode switching) posts CRTC register writes and fetch mode
+// changes, closing each set with a commit; core 1 (video loop) owns the MC6845 bus,
+// stages the set and applies it in the next vertical blank (crtc_shadow.h). Only the
+// producer writes head and only the consumer writes tail, so plain aligned 32-bit
+// loads/stores with acquire/release ordering are enough: no spinlock, and the consumer
+// never waits on the producer.
+// A second instance runs the other way: 3Dxh register writes the ISA window engine
+// captured on core 1 go to core 0, which owns the registers (cga_io.h).
+//
+// Message word: [23:16] opcode, [12:8] register, [7:0] value
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CORE_MAILBOX_SIZE 64 // Power of two; a full mode switch is 18 messages
+
+enum {
+    CORE_MAILBOX_CRTC_WRITE = 1, // MC6845 register <- value
+    CORE_MAILBOX_FETCH_MODE = 2, // value = video_mode_t for the fetch engine
+    CORE_MAILBOX_COMMIT = 3,     // Apply everything staged since the last commit in the next blank
+    CORE_MAILBOX_PAGE = 4,       // value = page the fetch engine shows, video_memory.h
+    CORE_MAILBOX_IO_WRITE = 5,   // Core 1 -> core 0: port 3D0h | register <- value
+};
+
+typedef struct {
+    uint32_t slots[CORE_MAILBOX_SIZE];
+    uint32_t head; // Written by the producer only
+    uint32_t tail; // Written by the consumer only
+} core_mailbox_t;
+
+static inline uint32_t core_mailbox_message(const uint8_t opcode, const uint8_t reg, const uint8_t value) {
+    return (uint32_t) opcode << 16 | (uint32_t) (reg & 0x1F) << 8 | value;
+}
+
+// Producer side: slots that can be posted without failing
+static inline uint32_t core_mailbox_free(core_mailbox_t *mailbox) {
+    return CORE_MAILBOX_SIZE - (mailbox->head - __atomic_load_n(&mailbox->tail, __ATOMIC_ACQUIRE));
+}
+
+// Producer side; false if the mailbox is full
+static inline bool core_mailbox_try_post(core_mailbox_t *mailbox, const uint32_t message) {
+    const uint32_t head = mailbox->head;
+    if (head - __atomic_load_n(&mailbox->tail, __ATOMIC_ACQUIRE) == CORE_MAILBOX_SIZE) {
+        return false;
+    }
+    mailbox->slots[head % CORE_MAILBOX_SIZE] = message;
+    __atomic_store_n(&mailbox->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Consumer side; false if there is nothing pending
+static inline bool core_mailbox_try_take(core_mailbox_t *mailbox, uint32_t *message) {
+    const uint32_t tail = mailbox->tail;
+    if (__atomic_load_n(&mailbox->head, __ATOMIC_ACQUIRE) == tail) {
+        return false;
+    }
+    *message = mailbox->slots[tail % CORE_MAILBOX_SIZE];
+    __atomic_store_n(&mailbox->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+// Core 1's copy of the MC6845 registers and the writes waiting for vertical blank.
+// Writes are staged into an open set and become pending only as a whole on commit,
+// so a mode switch never goes out half-done and a later write to the same register
+// (the cursor walk) replaces the earlier one: at most one write per register and frame.
+// Committing a value the chip already holds clears its dirty bit, so a mode switch only
+// puts the registers that differ between the two tables on the bus (80x25 -> 40x25 is
+// R0..R2). Pending writes are sent once the MA lines show the CRTC below the last
+// displayed row, so no visible frame is scanned with half-changed timings.
+//
+// There is no VSYNC pin on the RP2040 side; vertical blank is told from MA alone.
+// Within a frame MA = start + row * R1 + column, column 0..R0, so any MA at least
+// R6 * R1 + (R0 - R1) + 1 past the start address can only come from row R6 or later.
+// MA beyond (R4 + 1) * R1 + R0 means the frame is out of step with the registers
+// (R4 was lowered below the current row) and is not taken for a blank.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t regs[16];    // Values the MC6845 holds (or the write engine is about to write)
+    uint8_t pending[16]; // Committed values
+    uint16_t dirty;      // Bit n: pending[n] still has to go out
+    uint8_t open[16];    // Staged since the last commit
+    uint16_t open_mask;
+} crtc_shadow_t;
+
+static inline void crtc_shadow_init(crtc_shadow_t *shadow, const uint8_t regs[16]) {
+    for (int r = 0; r < 16; r++) {
+        shadow->regs[r] = shadow->pending[r] = regs[r];
+    }
+    shadow->dirty = shadow->open_mask = 0;
+}
+
+static inline void crtc_shadow_stage(crtc_shadow_t *shadow, const uint8_t reg, const uint8_t value) {
+    shadow->open[reg] = value;
+    shadow->open_mask |= 1u << reg;
+}
+
+static inline void crtc_shadow_commit(crtc_shadow_t *shadow) {
+    for (uint32_t mask = shadow->open_mask; mask; mask &= mask - 1) {
+        const int reg = __builtin_ctz(mask);
+        shadow->pending[reg] = shadow->open[reg];
+        if (shadow->pending[reg] != shadow->regs[reg]) {
+            shadow->dirty |= 1u << reg;
+        } else {
+            shadow->dirty &= ~(1u << reg);
+        }
+    }
+    shadow->open_mask = 0;
+}
+
+// Characters into the frame: MA relative to the start address
+static inline uint32_t crtc_shadow_frame_offset(const crtc_shadow_t *shadow, const uint32_t ma) {
+    const uint32_t start = (uint32_t) (shadow->regs[12] & 0x3F) << 8 | shadow->regs[13];
+    return (ma - start) & 0x3FFF;
+}
+
+// Whether one MA value lies in the vertical blank. The value has to be a settled one:
+// a GPIO read while MA changes is not (service_vblank() in main.c).
+static inline bool crtc_shadow_in_vblank(const crtc_shadow_t *shadow, const uint32_t ma) {
+    const uint8_t *r = shadow->regs;
+    const uint32_t blank = (uint32_t) r[6] * r[1] + (r[0] >= r[1] ? r[0] - r[1] : 0) + 1;
+    const uint32_t end = (uint32_t) (r[4] + 1) * r[1] + r[0];
+    const uint32_t offset = crtc_shadow_frame_offset(shadow, ma);
+    return offset >= blank && offset <= end;
+}
+
+// The first scanline of row R6 dips in and out of the blank test above (MA restarts
+// every scanline), so a frame is only counted once row 0 has been seen again.
+static inline bool crtc_shadow_in_first_row(const crtc_shadow_t *shadow, const uint32_t ma) {
+    return crtc_shadow_frame_offset(shadow, ma) < shadow->regs[1];
+}
+
+// Next register to write, lowest first; it counts as written from here on. -1 if none.
+static inline int crtc_shadow_next(crtc_shadow_t *shadow) {
+    if (!shadow->dirty) {
+        return -1;
+    }
+    const int reg = __builtin_ctz(shadow->dirty);
+    shadow->dirty &= shadow->dirty - 1;
+    shadow->regs[reg] = shadow->pending[reg];
+    return reg;
+}
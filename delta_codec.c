@@ -0,0 +1,124 @@
+#include "delta_codec.h"
+
+#include <string.h>
+
+bool delta_next(delta_reader_t *reader, delta_run_t *run) {
+    const uint8_t *pos = reader->pos;
+    if (pos >= reader->end) {
+        return false;
+    }
+    const uint8_t c = *pos++;
+    if (c < 0x80) {
+        run->op = DELTA_LITERAL;
+        run->length = c + 1u;
+        if ((size_t) (reader->end - pos) < run->length) {
+            return false;
+        }
+        run->data = pos;
+        pos += run->length;
+    } else {
+        if (pos >= reader->end) {
+            return false;
+        }
+        run->length = ((uint32_t) (c & 0x3F) << 8 | *pos++) + 1;
+        if (c < 0xC0) {
+            if (pos >= reader->end) {
+                return false;
+            }
+            run->op = DELTA_FILL;
+            run->value = *pos++;
+        } else {
+            run->op = DELTA_KEEP;
+        }
+    }
+    reader->pos = pos;
+    return true;
+}
+
+int32_t delta_span(const uint8_t *stream, const size_t length) {
+    delta_reader_t reader;
+    delta_run_t run;
+    int32_t span = 0;
+    delta_reader_init(&reader, stream, length);
+    while (delta_next(&reader, &run)) {
+        span += run.length;
+    }
+    return reader.pos == reader.end ? span : -1;
+}
+
+uint32_t delta_apply(uint8_t *dst, const uint8_t *base, uint32_t offset, const uint8_t *stream, const size_t length) {
+    delta_reader_t reader;
+    delta_run_t run;
+    delta_reader_init(&reader, stream, length);
+    while (delta_next(&reader, &run)) {
+        if (run.op == DELTA_LITERAL) {
+            memcpy(&dst[offset], run.data, run.length);
+        } else if (run.op == DELTA_FILL) {
+            memset(&dst[offset], run.value, run.length);
+        } else {
+            memcpy(&dst[offset], &base[offset], run.length);
+        }
+        offset += run.length;
+    }
+    return offset;
+}
+
+// Bytes from i on that match the base / repeat frame[i], up to one long run
+static uint32_t keep_length(const uint8_t *base, const uint8_t *frame, const uint32_t i, const uint32_t size) {
+    uint32_t n = 0;
+    while (i + n < size && n < DELTA_RUN_MAX && frame[i + n] == base[i + n]) n++;
+    return n;
+}
+
+static uint32_t fill_length(const uint8_t *frame, const uint32_t i, const uint32_t size) {
+    uint32_t n = 1;
+    while (i + n < size && n < DELTA_RUN_MAX && frame[i + n] == frame[i]) n++;
+    return n;
+}
+
+// Greedy: a keep run costs 2 bytes and a fill 3, so shorter ones stay inside a literal
+// (breaking it would cost a new control byte as well)
+size_t delta_encode(uint8_t *out, const size_t cap, const uint8_t *base, const uint8_t *frame, const uint32_t size,
+                    uint32_t *start, uint32_t *end) {
+    uint32_t i = *start;
+    while (i < size && frame[i] == base[i]) i++;
+    *start = i;
+
+    size_t n = 0;
+    size_t literal = SIZE_MAX; // Control byte of the open literal run
+    while (i < size) {
+        const uint32_t keep = keep_length(base, frame, i, size);
+        if (i + keep == size) {
+            break;
+        }
+        if (keep >= 3) {
+            if (n + 2 > cap) break;
+            out[n++] = 0xC0 | (keep - 1) >> 8;
+            out[n++] = (keep - 1) & 0xFF;
+            i += keep;
+            literal = SIZE_MAX;
+            continue;
+        }
+        const uint32_t fill = fill_length(frame, i, size);
+        if (fill >= 4) {
+            if (n + 3 > cap) break;
+            out[n++] = 0x80 | (fill - 1) >> 8;
+            out[n++] = (fill - 1) & 0xFF;
+            out[n++] = frame[i];
+            i += fill;
+            literal = SIZE_MAX;
+            continue;
+        }
+        if (literal != SIZE_MAX && out[literal] < DELTA_LITERAL_MAX - 1) {
+            if (n + 1 > cap) break;
+            out[literal]++;
+        } else {
+            if (n + 2 > cap) break;
+            literal = n;
+            out[n++] = 0;
+        }
+        out[n++] = frame[i++];
+    }
+    *end = i;
+    return n;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// Run-length delta of one video memory window against the page on screen. Pure C,
+// shared by the firmware (reader) and host tools (encoder).
+//
+// The base of a delta is the front page, i.e. the last frame the host flipped to. The
+// device builds the next frame in the back page: runs are applied in window order,
+// anything the stream does not cover is copied from the front when the page is flipped.
+// A status line update is then a few bytes on the wire instead of a whole frame.
+//
+// A stream is a sequence of runs, each introduced by a control byte c:
+//   0x00-0x7F  literal  the next c + 1 bytes are new data
+//   0x80-0xBF  fill     ((c & 0x3F) << 8 | next byte) + 1 copies of the byte after that
+//   0xC0-0xFF  keep     ((c & 0x3F) << 8 | next byte) + 1 bytes as on the front page
+// Long runs reach 16384 bytes, a whole graphics window.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DELTA_LITERAL_MAX 128
+#define DELTA_RUN_MAX 16384
+
+typedef enum {
+    DELTA_LITERAL,
+    DELTA_FILL,
+    DELTA_KEEP,
+} delta_op_t;
+
+typedef struct {
+    delta_op_t op;
+    uint32_t length;
+    const uint8_t *data; // DELTA_LITERAL
+    uint8_t value;       // DELTA_FILL
+} delta_run_t;
+
+// ---------------- Device side ----------------
+
+typedef struct {
+    const uint8_t *pos, *end;
+} delta_reader_t;
+
+static inline void delta_reader_init(delta_reader_t *reader, const uint8_t *stream, const size_t length) {
+    reader->pos = stream;
+    reader->end = stream + length;
+}
+
+// Next run; false at the end of the stream or on a truncated run
+bool delta_next(delta_reader_t *reader, delta_run_t *run);
+
+// Bytes of the window the stream covers, or -1 if it is malformed.
+// Checked before anything is applied, so a bad packet leaves the page untouched.
+int32_t delta_span(const uint8_t *stream, size_t length);
+
+// Apply a whole stream to dst[offset..] with base as the front page; returns the
+// window offset after the last run. The firmware uses its own loops (video_memory.c),
+// this is the reference the host tools check against.
+uint32_t delta_apply(uint8_t *dst, const uint8_t *base, uint32_t offset, const uint8_t *stream, size_t length);
+
+// ---------------- Host side ----------------
+
+// Encode frame against base, both `size` bytes, from *start on into at most cap bytes
+// (cap >= 4). Unchanged bytes before the first difference are skipped and *start moved
+// past them; the stream ends at *end, leaving out unchanged bytes at the tail.
+// Returns the stream size, 0 once nothing from *start on differs.
+size_t delta_encode(uint8_t *out, size_t cap, const uint8_t *base, const uint8_t *frame, uint32_t size,
+                    uint32_t *start, uint32_t *end);
@@ -0,0 +1,63 @@
+#pragma once
+
+// Thin hardware abstraction for everything main.c needs from the board:
+// GPIO bank, delays, the PIO clock generator and the USB console.
+// The Pico SDK backend (hal_pico.h) is a set of inline wrappers and costs nothing;
+// building with CGA_HOST=1 selects host/hal_host.h, a simulated pin bank with
+// virtual time that lets the firmware run under host/cga_sim.
+//
+// Backend API:
+//   hal_system_init(sys_hz)            core voltage, sys clock, USB stdio
+//   hal_gpio_init(pin)                 hal_gpio_set_dir(pin, out)
+//   hal_gpio_set_dir_masked(mask, v)   hal_gpio_put(pin, v)
+//   hal_gpio_put_masked(mask, v)       hal_gpio_get_all()
+//   hal_sleep_us(us)                   hal_busy_wait_ms(ms)
+//   hal_busy_wait_cycles(cycles)       inline spin, usable with interrupts off
+//   hal_clock_init(pin, freq)          hal_clock_set_div(div)  16.8 clock SM divider
+//   hal_console_read(buf, max)         bytes waiting on the USB CDC console, never blocks
+//   hal_console_write(buf, len)        raw bytes, no CR/LF translation
+//   hal_time_us()
+//   hal_flash_read(offset, buf, len)   bytes at `offset` into the flash, through XIP
+//   hal_core1_launch(entry)            hal_interrupts_disable()
+//
+// PIO video fetch engine (video.pio): MA/RA samples arrive in a FIFO, glyph|attr
+// pairs leave through another one and are driven onto D0..D7 at fixed DOTCLK latencies.
+//   hal_video_init(addr_base, data_base)
+//   hal_video_addr_pending()           hal_video_addr_get()
+//   hal_video_data_put(glyph | attr << 8)
+//   hal_video_fetch_loop(loop, table)  VIDEO_FETCH_ASM: video_fetch.S serves the FIFOs itself
+//   hal_video_dma_init(addr_base, data_base, layout)   DMA lookup chain instead of the CPU
+//   hal_video_dma_set_layout(layout)                   (video_dma.h)
+//
+// MC6845 register write engine (mc6845_bus.pio): 6800 bus cycles from a FIFO,
+// D0..D7 are borrowed from the video engine while writes are queued.
+//   hal_crtc_write_init(ctrl_base, data_base)
+//   hal_crtc_write_ready()             hal_crtc_write(reg, value)
+//   hal_crtc_write_poll()              returns D0..D7 to the video engine when idle
+//
+// ISA memory window (isa_vram.pio, CGA_ISA_VRAM boards): CPU reads of B8000h are
+// answered from the window by PIO + DMA, CPU writes wait in a FIFO for core 1.
+//   hal_isa_vram_init(addr_base, data_base, oe_pin, wr_pin, window)
+//   hal_isa_vram_set_window(window)    (isa_vram.h)
+//   hal_isa_vram_write_pending()       hal_isa_vram_write_get()
+//
+// 3DAh status engine (raster_status.pio): a DE/VSYNC timeline played in DOTCLKs from
+// an RA0 edge, each status stored by DMA into a byte.
+//   hal_raster_init(ra0_pin, target)   hal_raster_set_target(target)
+//   hal_raster_start(timeline, words)  during line 0 of row 0 (raster_status_dma.h)
+//   hal_raster_stop()                  hal_raster_status()
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "isa_vram.h"
+#include "video_memory.h"
+
+#define HAL_GPIO_IN  false
+#define HAL_GPIO_OUT true
+
+#if CGA_HOST
+#include "host/hal_host.h"
+#else
+#include "hal_pico.h"
+#endif
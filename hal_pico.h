@@ -0,0 +1,229 @@
+#pragma once
+
+// Pico SDK backend of hal.h
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/multicore.h"
+#include "pico/time.h"
+#include "pico/stdio_usb.h"
+#include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/sync.h"
+#include <hardware/structs/vreg_and_chip_reset.h>
+
+#include "clock_pio.h"
+#include "mc6845_bus_pio.h"
+#include "raster_status_dma.h"
+#include "video_dma.h"
+#include "video_pio.h"
+#if CGA_ISA_VRAM
+#include "isa_vram_dma.h"
+#endif
+
+static inline void hal_system_init(const uint32_t sys_hz) {
+    // Configure RP2040 system clock
+    hw_set_bits(&vreg_and_chip_reset_hw->vreg, VREG_AND_CHIP_RESET_VREG_VSEL_BITS);
+    set_sys_clock_hz(sys_hz, true);
+    busy_wait_ms(25);
+
+    stdio_usb_init();
+    busy_wait_ms(1000);
+}
+
+__always_inline static void hal_gpio_init(const uint32_t pin) {
+    gpio_init(pin);
+}
+
+__always_inline static void hal_gpio_set_dir(const uint32_t pin, const bool out) {
+    gpio_set_dir(pin, out);
+}
+
+__always_inline static void hal_gpio_set_dir_masked(const uint32_t mask, const uint32_t value) {
+    gpio_set_dir_masked(mask, value);
+}
+
+__always_inline static void hal_gpio_put(const uint32_t pin, const bool value) {
+    gpio_put(pin, value);
+}
+
+__always_inline static void hal_gpio_put_masked(const uint32_t mask, const uint32_t value) {
+    gpio_put_masked(mask, value);
+}
+
+__always_inline static uint32_t hal_gpio_get_all(void) {
+    return gpio_get_all();
+}
+
+__always_inline static void hal_sleep_us(const uint64_t us) {
+    sleep_us(us);
+}
+
+__always_inline static void hal_busy_wait_ms(const uint32_t ms) {
+    busy_wait_ms(ms);
+}
+
+// Inline spin, safe from RAM-resident code with interrupts off (sleep_us is neither)
+__always_inline static void hal_busy_wait_cycles(const uint32_t cycles) {
+    busy_wait_at_least_cycles(cycles);
+}
+
+static inline void hal_core1_launch(void (*entry)(void)) {
+    multicore_launch_core1(entry);
+}
+
+__always_inline static void hal_interrupts_disable(void) {
+    (void) save_and_disable_interrupts();
+}
+
+static inline void hal_clock_init(const uint32_t pin, const float freq) {
+    init_clock_pio(PIO_CLOCK, SM_CLOCK, pin, freq);
+}
+
+// Core 1 switches DOTCLK in the blank: a precomputed 16.8 divider, one register write
+__always_inline static void hal_clock_set_div(const uint32_t div) {
+    pio_sm_set_clkdiv_int_frac(PIO_CLOCK, SM_CLOCK, div >> 8, div & 0xFF);
+}
+
+// Whatever the CDC endpoint has buffered, in one copy rather than a call per byte
+static inline uint32_t hal_console_read(uint8_t *buf, const uint32_t max) {
+    const int count = stdio_get_until((char *) buf, (int) max, get_absolute_time());
+    return count > 0 ? (uint32_t) count : 0;
+}
+
+static inline void hal_console_write(const uint8_t *buf, const uint32_t len) {
+    stdio_put_string((const char *) buf, (int) len, false, false);
+}
+
+__always_inline static uint64_t hal_time_us(void) {
+    return time_us_64();
+}
+
+static inline void hal_flash_read(const uint32_t offset, void *buf, const uint32_t len) {
+    memcpy(buf, (const void *) (XIP_BASE + offset), len);
+}
+
+// ---------------- PIO video fetch engine (video_pio.h) ----------------
+
+static inline void hal_video_init(const uint32_t addr_pin_base, const uint32_t data_pin_base) {
+    init_video_pio(PIO_VIDEO, addr_pin_base, data_pin_base);
+}
+
+__always_inline static bool hal_video_addr_pending(void) {
+    return !pio_sm_is_rx_fifo_empty(PIO_VIDEO, SM_VIDEO_ADDR);
+}
+
+__always_inline static uint32_t hal_video_addr_get(void) {
+    return pio_sm_get(PIO_VIDEO, SM_VIDEO_ADDR);
+}
+
+__always_inline static void hal_video_data_put(const uint16_t value) {
+    pio_sm_put(PIO_VIDEO, SM_VIDEO_DATA, value);
+}
+
+#if VIDEO_FETCH_ASM
+// The assembly loop reads RXF and writes TXF of the two SMs at fixed offsets
+static_assert(SM_VIDEO_ADDR == 0 && SM_VIDEO_DATA == 2, "SM_ADDR/SM_DATA in video_fetch.S");
+
+__always_inline static void hal_video_fetch_loop(const video_fetch_loop_t loop, const void *table) {
+    loop(table, PIO_VIDEO);
+}
+#endif
+
+// Same PIO front end with the DMA lookup chain behind it (video_dma.h)
+static inline void hal_video_dma_init(const uint32_t addr_pin_base, const uint32_t data_pin_base,
+                                      const video_dma_layout_t *layout) {
+    video_dma_init(addr_pin_base, data_pin_base, layout);
+}
+
+__always_inline static void hal_video_dma_set_layout(const video_dma_layout_t *layout) {
+    video_dma_set_layout(layout);
+}
+
+// D0..D7 belong to the data-out SM; hand them to the register write engine and back.
+// Only FUNCSEL changes (pads were set up by gpio_init), so this stays inline for core 1.
+__always_inline static void hal_data_bus_function(const uint32_t data_pin_base, const uint32_t function) {
+    for (uint32_t pin = data_pin_base; pin < data_pin_base + 8; pin++) {
+        hw_write_masked(&iobank0_hw->io[pin].ctrl, function << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB,
+                        IO_BANK0_GPIO0_CTRL_FUNCSEL_BITS);
+    }
+}
+
+// ---------------- MC6845 register write engine (mc6845_bus_pio.h) ----------------
+
+static uint32_t hal_crtc_data_pin_base;
+static bool hal_crtc_bus_claimed;
+
+static inline void hal_crtc_write_init(const uint32_t ctrl_pin_base, const uint32_t data_pin_base) {
+    hal_crtc_data_pin_base = data_pin_base;
+    init_mc6845_bus_pio(PIO_CRTC, SM_CRTC, ctrl_pin_base, data_pin_base);
+}
+
+__always_inline static bool hal_crtc_write_ready(void) {
+    return !pio_sm_is_tx_fifo_full(PIO_CRTC, SM_CRTC);
+}
+
+// Queue one register write; the caller checks hal_crtc_write_ready() first
+__always_inline static void hal_crtc_write(const uint8_t reg, const uint8_t value) {
+    if (!hal_crtc_bus_claimed) {
+        hal_data_bus_function(hal_crtc_data_pin_base, PIO_CRTC == pio0 ? GPIO_FUNC_PIO0 : GPIO_FUNC_PIO1);
+        hal_crtc_bus_claimed = true;
+    }
+    pio_sm_put(PIO_CRTC, SM_CRTC, reg | (uint32_t) value << 8);
+    // Cleared after the put: from here on a stall can only mean the queue ran dry
+    PIO_CRTC->fdebug = 1u << (PIO_FDEBUG_TXSTALL_LSB + SM_CRTC);
+}
+
+// Hand D0..D7 back to the video engine once the queued writes are done
+__always_inline static void hal_crtc_write_poll(void) {
+    if (hal_crtc_bus_claimed && pio_sm_is_tx_fifo_empty(PIO_CRTC, SM_CRTC) &&
+        (PIO_CRTC->fdebug & (1u << (PIO_FDEBUG_TXSTALL_LSB + SM_CRTC)))) {
+        hal_data_bus_function(hal_crtc_data_pin_base, PIO_VIDEO == pio0 ? GPIO_FUNC_PIO0 : GPIO_FUNC_PIO1);
+        hal_crtc_bus_claimed = false;
+    }
+}
+
+#if CGA_ISA_VRAM
+// ---------------- ISA memory window (isa_vram_pio.h) ----------------
+
+static inline void hal_isa_vram_init(const uint32_t addr_pin_base, const uint32_t data_pin_base, const uint32_t oe_pin,
+                                     const uint32_t wr_pin, const isa_vram_window_t *window) {
+    isa_vram_dma_init(addr_pin_base, data_pin_base, oe_pin, wr_pin, window);
+}
+
+__always_inline static void hal_isa_vram_set_window(const isa_vram_window_t *window) {
+    isa_vram_dma_set_window(window);
+}
+
+__always_inline static bool hal_isa_vram_write_pending(void) {
+    return !pio_sm_is_rx_fifo_empty(PIO_ISA_WRITE, SM_ISA_WRITE);
+}
+
+// GPIO0..26 as sampled: A0..A13, D0..D7 from PIN_DATA_BASE, /VRAMOE
+__always_inline static uint32_t hal_isa_vram_write_get(void) {
+    return pio_sm_get(PIO_ISA_WRITE, SM_ISA_WRITE);
+}
+#endif
+
+// ---------------- 3DAh status engine (raster_status_pio.h) ----------------
+
+static inline void hal_raster_init(const uint32_t ra0_pin, uint8_t *target) {
+    raster_status_dma_init(ra0_pin, target);
+}
+
+__always_inline static void hal_raster_start(const uint32_t *timeline, const uint32_t words) {
+    raster_status_dma_start(timeline, words);
+}
+
+__always_inline static void hal_raster_stop(void) {
+    raster_status_dma_stop();
+}
+
+__always_inline static void hal_raster_set_target(uint8_t *target) {
+    raster_status_dma_set_target(target);
+}
+
+__always_inline static uint8_t hal_raster_status(void) {
+    return raster_status_dma_get();
+}
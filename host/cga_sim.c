@@ -0,0 +1,521 @@
+// Host-side harness for the firmware.
+//
+// replay: every character clock the MC6845 model produces MA/RA exactly as the
+//   RP2040 samples them on GPIO0..16; whenever the sample changes, the fetch kernel of
+//   the mode's descriptor (video_registry.h) is called and timed, and the resulting
+//   data bus stream is hashed so that regressions in the fetch path show up as a
+//   changed digest. Each pair is also checked against video_dma_lookup(), the pointer
+//   arithmetic of the DMA chain (exit status 1 on a mismatch).
+// modes: host/mode_check.c, every mode descriptor against the CRTC model.
+// kernels: host/kernel_bench.c, host cycles per fetch of the per-mode kernels against
+//   a run-time layout lookup and a mode test per sample.
+// bus: runs main.c itself (cga_setup, cga_poll on core 0 and cga_video_poll on
+//   core 1, interleaved on their own virtual clocks) on the simulated board of
+//   host/hal_host.c. The CRTC model is clocked from the virtual time and the PIO
+//   clock frequency, latches register writes from the E strobes and feeds the
+//   simulated video_addr/video_data FIFOs; plain GPIO reads of MA/RA see the bits
+//   settle for tMAD after each change. The harness reports the sys_clk cycles
+//   spent per bus transaction, the write bursts that began while a displayed row
+//   was being scanned (exit status 1 past setup) and the displayed addresses whose
+//   byte was dropped or late.
+// upload: the same board with host/upload_link.c on the console instead of keys,
+//   streaming 320x200 frames at 60 fps through upload_protocol.h over a 1 MB/s link,
+//   then checks that the page on screen is the last frame sent. With "delta" every
+//   frame after the first goes out as a delta against the previous one.
+// delta: host/delta_bench.c, bytes on the wire and apply time of delta streams.
+// isa: host/isa_bus.c, the B8000h window against isa-vram.pld; in CGA_ISA_VRAM builds
+//   also XT and AT memory cycles against the running firmware, with response times.
+// retrace: host/retrace.c, CGA.md's wait-for-retrace loop on an XT and an AT against
+//   the 3DAh status engine (the ISA window in CGA_ISA_VRAM builds), every read checked
+//   against the model's DE and VSYNC; keys as for bus, "tg" by default.
+// io: host/io_ports.c, OUTs to the 3Dxh registers (console packets, or register cycles
+//   in CGA_ISA_VRAM builds) while 3DAh is read every 37 us and held against the model's
+//   DE and VSYNC; every displayed byte has to be fetched on time meanwhile.
+//
+// Build: cmake -S . -B build-host -DCGA_HOST=ON && cmake --build build-host
+// Usage: cga_sim [all|replay|bus] [frames] [keys]   (all: replay, then bus)
+//        cga_sim upload [frames] [corrupt_packet] [delta]
+//        cga_sim delta [frames]
+//        cga_sim isa [frames]   (cmake ... -DCGA_FETCH_DMA=OFF -DCGA_ISA_VRAM=ON for the bus run)
+//        cga_sim retrace [frames] [keys]
+//        cga_sim io
+//        cga_sim modes
+//        cga_sim kernels [passes]
+//   keys are fed to the console one per 100 ms of virtual time, e.g. "tg";
+//   corrupt_packet damages that packet once on the wire to exercise NAK and resend
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "board.h"
+#include "cga.h"
+#include "delta_bench.h"
+#include "cga_io.h"
+#include "hal.h"
+#include "io_ports.h"
+#include "isa_bus.h"
+#include "kernel_bench.h"
+#include "mode_check.h"
+#include "retrace.h"
+#include "mc6845_model.h"
+#include "upload_link.h"
+#include "video_memory.h"
+#include "video_modes.h"
+#include "video_registry.h"
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Cost of the timing bracket itself, subtracted from every sample
+static uint64_t timer_overhead_ns(void) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 10000; i++) {
+        const uint64_t t0 = now_ns();
+        const uint64_t t1 = now_ns();
+        if (t1 - t0 < best) best = t1 - t0;
+    }
+    return best;
+}
+
+// false if the DMA chain would put a different byte on the bus than the kernel
+static bool replay_mode(const video_mode_desc_t *m, const int frames, const uint64_t overhead) {
+    mc6845_model_t crtc;
+    mc6845_model_init(&crtc, m->crtc);
+    video_memory_init();
+    const video_dma_layout_t layout = video_mode_layout(m, 0);
+    const double char_clock_hz = m->dotclk_hz / 8; // character.pld divider
+
+    const uint32_t frame_clocks = mc6845_model_frame_clocks(m->crtc);
+    uint32_t prev_addr = 0xFFFFFFFF;
+    uint64_t fetches = 0, dma_mismatch = 0, de_clocks = 0;
+    uint64_t total_ns = 0, min_ns = UINT64_MAX, max_ns = 0;
+    uint32_t digest = 2166136261u; // FNV-1a over the data bus stream
+    volatile uint16_t sink;
+
+    for (uint64_t clk = 0; clk < (uint64_t) frame_clocks * frames; clk++) {
+        mc6845_outputs_t pins;
+        mc6845_model_clock(&crtc, &pins);
+        de_clocks += pins.de;
+
+        // Same sample as main(): gpio_get_all() & 0x1FFFF, RA2..RA0 on GPIO14..16
+        const uint32_t addr = pins.ma | (uint32_t) (pins.ra & 7) << 14;
+        if (addr == prev_addr) continue;
+        prev_addr = addr;
+
+        const uint64_t t0 = now_ns();
+        const uint16_t data = m->fetch(layout.table, addr);
+        const uint64_t t1 = now_ns();
+        sink = data;
+        // The DMA chain must put the same byte on the bus
+        dma_mismatch += video_dma_lookup(&layout, addr) != data;
+
+        const uint64_t ns = t1 - t0 > overhead ? t1 - t0 - overhead : 0;
+        total_ns += ns;
+        if (ns < min_ns) min_ns = ns;
+        if (ns > max_ns) max_ns = ns;
+        fetches++;
+        digest = (digest ^ (data & 0xFF)) * 16777619u;
+        digest = (digest ^ data >> 8) * 16777619u;
+    }
+    (void) sink;
+
+    printf("%-18s R0..R15 -> %u clocks/frame, %.2f Hz, budget %.1f ns/char\n", m->name, frame_clocks,
+           char_clock_hz / frame_clocks, 1e9 / char_clock_hz);
+    printf("  frames %d, DE clocks %llu, fetches %llu, DMA chain mismatches %llu\n", frames,
+           (unsigned long long) de_clocks, (unsigned long long) fetches, (unsigned long long) dma_mismatch);
+    printf("  fetch ns min/avg/max %llu/%.1f/%llu, digest %08x\n", (unsigned long long) (fetches ? min_ns : 0),
+           fetches ? (double) total_ns / fetches : 0.0, (unsigned long long) max_ns, digest);
+    return dma_mismatch == 0;
+}
+
+// ==========================================================
+// Simulated board for main.c
+// ==========================================================
+
+typedef struct {
+    mc6845_model_t crtc;
+    uint64_t last_cycles;  // Virtual time the CRTC has been run up to
+    double half_phase;     // Fractional half-character steps carried over
+    bool second_half;      // Next half step is the middle of a character
+    uint32_t sample;       // MA/RA currently on GPIO0..16
+    uint32_t prev_sample;  // MA/RA before the last change, still settling until settle_end
+    uint64_t settle_end;
+    uint32_t glitch_seed;
+    bool slot_pending;     // video_data owes an output for the current character
+    bool slot_shown;       // ... and it reaches the screen: counted below
+    uint64_t presented, dropped, on_time, late;
+
+    uint64_t bus_start, bus_count, bus_cycles, bus_min, bus_max;
+    bool bus_strobed;      // E pulsed since CS went low
+    uint64_t bus_end;      // CS rising edge of the last transaction
+    uint64_t bursts, bursts_visible; // Back-to-back writes; those started outside vertical blank
+    uint64_t loop_bursts_visible;    // The latter after setup: a blank test that misfired
+    const char *keys;
+    uint32_t key_index;
+    uint32_t isa_levels; // isa-vram.pld strobes, idle high; the cycles come from isa_bus.c
+
+    bool de, vsync;        // MC6845 outputs of the current character
+    uint64_t edges[8];     // Virtual times of the last DE/VSYNC changes, a ring
+    uint32_t edge_count;
+    uint64_t next_status;  // Next 3DAh read (RUN_IO)
+    bool retimed;          // R0..R9 written; the CRTC settles with the next frame
+    uint32_t retimed_frame;
+    void (*on_status_edge)(bool de, bool vsync, uint64_t at);
+    struct {
+        bool pending;      // Read disagrees with the model, not yet held against the edges
+        uint64_t at;
+        uint8_t status;
+        bool de, vsync, settling;
+    } status_read;
+} board_t;
+
+typedef enum { RUN_KEYS, RUN_UPLOAD, RUN_ISA, RUN_IO, RUN_RETRACE } run_t;
+
+static board_t board;
+
+// MC6845 tMAD: MA/RA are valid this long after the CLK edge that changes them
+#define MA_SETTLE_NS 160
+
+// GPIO0..16 as a plain SIO read sees them: while MA/RA settle every changing bit is old
+// or new at random, so 1023 -> 1024 may read back as 2047 (the PIO captures on DOTCLK
+// edges and is not modelled this way)
+static uint32_t board_pins(void) {
+    uint32_t pins = board.sample;
+    if (hal_host.cycles < board.settle_end) {
+        board.glitch_seed = board.glitch_seed * 1664525u + 1013904223u;
+        pins ^= (board.sample ^ board.prev_sample) & board.glitch_seed; // Bits still at their old level
+    }
+    return pins | board.isa_levels;
+}
+
+// Runs the CRTC up to the current virtual time in half-character steps: MA/RA change
+// at the start of a character (captured by video_addr), the glyph|attr pair is due
+// VIDEO_DATA_LATENCY = 4 DOTCLKs later, i.e. in the middle of the character.
+static void board_advance(void) {
+    // The core that is behind may look at the board, it sees the latest state
+    if (hal_host.cycles <= board.last_cycles) {
+        hal_host.in = board_pins();
+        return;
+    }
+    const uint64_t elapsed = hal_host.cycles - board.last_cycles;
+    board.last_cycles = hal_host.cycles;
+    if (hal_host.clock_freq <= 0) return;
+
+    // MC6845 CLK is DOTCLK / 8 from character.pld
+    board.half_phase += (double) elapsed * (hal_host.clock_freq / 4) / hal_host.sys_hz;
+    while (board.half_phase >= 1.0) {
+        board.half_phase -= 1.0;
+        if (board.second_half) {
+            if (board.slot_pending) {
+                uint16_t data;
+                if (hal_host_video_output(&data)) board.on_time += board.slot_shown;
+                else board.late += board.slot_shown;
+                board.slot_pending = false;
+            }
+        } else {
+            mc6845_outputs_t pins;
+            mc6845_model_clock(&board.crtc, &pins);
+            // The character began this many half steps before the current time
+            const uint64_t at =
+                hal_host.cycles - (uint64_t) (board.half_phase * hal_host.sys_hz / (hal_host.clock_freq / 4));
+            if (pins.de != board.de || pins.vsync != board.vsync) {
+                board.edges[board.edge_count++ % 8] = at;
+                board.de = pins.de;
+                board.vsync = pins.vsync;
+                if (board.on_status_edge) board.on_status_edge(pins.de, pins.vsync, at);
+            }
+            const uint32_t sample = pins.ma << PIN_MA_BASE | (uint32_t) (pins.ra & 7) << PIN_RA_BASE;
+            if (sample != board.sample) {
+                hal_host_raster_input(sample, at);
+                // Only bytes that reach the screen count: not those of blanked characters
+                // (the fetch engine restarts in the blank on a mode switch), nor the frame
+                // core 1 starts in, which the capture FIFO spends unattended since setup
+                const bool shown = pins.de && cga_video_frames();
+                board.presented += shown;
+                board.prev_sample = board.sample;
+                board.sample = sample;
+                board.settle_end = at + (uint64_t) (MA_SETTLE_NS * 1e-9 * hal_host.sys_hz);
+                if (hal_host_video_capture(sample)) {
+                    board.slot_pending = true;
+                    board.slot_shown = shown;
+                } else {
+                    board.dropped += shown;
+                }
+            }
+        }
+        board.second_half = !board.second_half;
+    }
+    hal_host.in = board_pins();
+}
+
+static void board_on_input(void) {
+    board_advance();
+}
+
+static void board_on_output(const uint32_t prev, const uint32_t now) {
+    board_advance();
+
+    const uint32_t cs = 1u << PIN_MC6845_CS, e = 1u << PIN_MC6845_E;
+    if ((prev & cs) && !(now & cs)) {
+        // More than 1 us since the last write: a new burst
+        if (!board.bus_end || hal_host.cycles - board.bus_end > hal_host.sys_hz / MHZ) {
+            board.bursts++;
+            if (!board.crtc.in_adjust && board.crtc.row < board.crtc.regs[6]) board.bursts_visible++;
+        }
+        board.bus_start = hal_host.cycles;
+        board.bus_strobed = false;
+    } else if (!(prev & cs) && (now & cs) && board.bus_strobed) {
+        board.bus_end = hal_host.cycles;
+        const uint64_t cycles = hal_host.cycles - board.bus_start;
+        board.bus_count++;
+        board.bus_cycles += cycles;
+        if (cycles < board.bus_min) board.bus_min = cycles;
+        if (cycles > board.bus_max) board.bus_max = cycles;
+    }
+
+    // 6800 bus: the MC6845 latches on the falling edge of E while CS is low and R/W is low
+    if ((prev & e) && !(now & e) && !(now & cs) && !(now & 1u << PIN_MC6845_RW)) {
+        board.bus_strobed = true;
+        if (now >> PIN_MC6845_RS & 1 && board.crtc.address < 10) {
+            board.retimed = true;
+            board.retimed_frame = board.crtc.frame;
+        }
+        mc6845_model_bus_write(&board.crtc, now >> PIN_MC6845_RS & 1, now >> PIN_DATA_BASE & 0xFF);
+    }
+}
+
+static uint32_t board_console_read(uint8_t *buf, const uint32_t max) {
+    if (!max || !board.keys || !board.keys[board.key_index]) return 0;
+    if (hal_host_time_us() < (board.key_index + 1) * 100000.0) return 0;
+    buf[0] = board.keys[board.key_index++];
+    return 1;
+}
+
+// The frame a timing write lands in runs on a mix of old and new registers; the
+// firmware's status engine starts again with line 1 of the next one
+static bool board_settling(void) {
+    const mc6845_model_t *crtc = &board.crtc;
+    return board.retimed && (crtc->frame == board.retimed_frame ||
+                             (crtc->frame == board.retimed_frame + 1 && !crtc->row && !crtc->ra && !crtc->in_adjust));
+}
+
+static bool near_edge(const uint64_t at) {
+    const uint64_t tolerance = (uint64_t) (IO_PORTS_EDGE_US * hal_host.sys_hz / 1e6);
+    for (uint32_t i = 0; i < 8 && i < board.edge_count; i++) {
+        const uint64_t edge = board.edges[i];
+        if ((edge > at ? edge - at : at - edge) <= tolerance) return true;
+    }
+    return false;
+}
+
+// A read that disagrees with the model is judged once the board has run past the edge
+// that may follow it
+static void resolve_status_read(void) {
+    if (board.status_read.pending) {
+        io_ports_sample(board.status_read.status, board.status_read.de, board.status_read.vsync,
+                        near_edge(board.status_read.at), board.status_read.settling);
+        board.status_read.pending = false;
+    }
+}
+
+// An IN from 3DAh on core 0 at its current virtual time, or once the board gets there:
+// core 1 may have run it ahead, up to where it has served every character
+static void sample_status(void) {
+    if (hal_host.cycles < board.next_status) return;
+    if (hal_host.cycles < board.last_cycles) hal_host_spend(board.last_cycles - hal_host.cycles);
+    board.next_status = hal_host.cycles + hal_host.sys_hz / 1000000 * 37;
+    board_advance();
+    resolve_status_read();
+    const uint8_t status = cga_io_read(CGA_IO_STATUS);
+    const bool settling = board_settling();
+    const uint8_t expected = CGA_STATUS_IDLE | (board.de ? 0 : CGA_STATUS_DISPLAY_OFF) |
+                             (board.vsync ? CGA_STATUS_VRETRACE : 0);
+    if (status == expected) {
+        io_ports_sample(status, board.de, board.vsync, false, settling);
+    } else {
+        board.status_read.pending = true;
+        board.status_read.at = hal_host.cycles;
+        board.status_read.status = status;
+        board.status_read.de = board.de;
+        board.status_read.vsync = board.vsync;
+        board.status_read.settling = settling;
+    }
+}
+
+static void bus_report(const char *stage) {
+    printf("  %-6s bus transactions %llu, cycles min/avg/max %llu/%.0f/%llu (%.2f us avg)\n", stage,
+           (unsigned long long) board.bus_count, (unsigned long long) (board.bus_count ? board.bus_min : 0),
+           board.bus_count ? (double) board.bus_cycles / board.bus_count : 0.0, (unsigned long long) board.bus_max,
+           board.bus_count ? (double) board.bus_cycles / board.bus_count * 1e6 / hal_host.sys_hz : 0.0);
+    printf("  %-6s write bursts %llu, %llu started in a displayed row\n", stage, (unsigned long long) board.bursts,
+           (unsigned long long) board.bursts_visible);
+    board.bus_count = board.bus_cycles = board.bus_max = 0;
+    board.bursts = board.bursts_visible = 0;
+    board.bus_min = UINT64_MAX;
+}
+
+static void run_firmware(const int frames, const char *keys, const run_t run) {
+    const bool upload = run == RUN_UPLOAD;
+    memset(&board, 0, sizeof(board));
+    board.bus_min = UINT64_MAX;
+    board.keys = keys;
+    board.isa_levels = CGA_ISA_VRAM ? 1u << PIN_ISA_VRAMOE | 1u << PIN_ISA_VRAMWR : 0;
+    mc6845_model_init(&board.crtc, (const uint8_t[16]) {0});
+
+    hal_host_reset(SYSTEM_CLOCK_HZ);
+    hal_host.on_input = board_on_input;
+    hal_host.on_output = board_on_output;
+    hal_host.console_read = upload ? upload_link_read : board_console_read;
+    hal_host.console_write = upload ? upload_link_write : NULL;
+    if (run == RUN_IO) {
+        hal_host.console_read = io_ports_read;
+        hal_host.console_write = io_ports_write;
+    }
+
+    if (upload) {
+        printf("main.c on the simulated board, %d frame(s), upload stream\n", frames);
+    } else if (run == RUN_ISA) {
+        printf("main.c on the simulated board, ISA memory cycles\n");
+    } else if (run == RUN_RETRACE) {
+        printf("main.c on the simulated board, %d frame(s), keys \"%s\", 3DAh retrace loops\n", frames, keys);
+    } else if (run == RUN_IO) {
+        printf("main.c on the simulated board, 3Dxh registers (%s)\n",
+               CGA_ISA_VRAM ? "ISA register cycles" : "UPLOAD_PORT packets");
+    } else {
+        printf("main.c on the simulated board, %d frame(s), keys \"%s\"\n", frames, keys ? keys : "");
+    }
+    cga_setup();
+    bus_report("setup");
+
+    // Each step runs the core whose virtual clock is behind; the harness calls
+    // cga_video_poll() itself instead of entering the endless core 1 loop.
+    const uint64_t start = hal_host.cycles;
+    if (run == RUN_ISA) isa_bus_init(frames, start);
+    if (run == RUN_RETRACE) {
+        retrace_init(start);
+        board.on_status_edge = retrace_edge;
+    }
+    // The ISA run goes on for every workload in turn
+    uint64_t run_cycles = (uint64_t) ((run == RUN_ISA ? 6 * frames + 1 : frames) * (double) hal_host.sys_hz / 60);
+    if (run == RUN_IO) run_cycles = (uint64_t) (io_ports_run_us() * hal_host.sys_hz / 1e6);
+    uint64_t polls = 0, video_polls = 0;
+    board.presented = board.dropped = board.on_time = board.late = 0;
+    hal_host.core_cycles[0] = hal_host.cycles;
+    while (hal_host.core_cycles[0] < run_cycles) {
+        if (hal_host.core1_entry && hal_host.core_cycles[1] < hal_host.core_cycles[0]) {
+            hal_host_select_core(1);
+            const uint64_t before = hal_host.cycles;
+            cga_video_poll();
+            // An idle pass is still a mailbox load and a branch or two
+            if (hal_host.cycles == before) hal_host_spend(4);
+            video_polls++;
+        } else {
+            hal_host_select_core(0);
+            if (run == RUN_IO) {
+                // Core 0 is not ahead of core 1 here: after cga_poll() it may be, and an IN
+                // then would run the CRTC past characters core 1 has not served yet
+                io_ports_poll(&board.crtc);
+                sample_status();
+            }
+            const uint64_t before = hal_host.cycles;
+            cga_poll();
+            // Console input held back (flip in flight): a few loads and compares
+            if (hal_host.cycles == before) hal_host_spend(4);
+            polls++;
+        }
+        hal_host.core_cycles[hal_host.core] = hal_host.cycles;
+        if (run == RUN_ISA || run == RUN_RETRACE) {
+            // A cycle is issued once neither core can still act before it
+            const uint64_t behind = hal_host.core1_entry && hal_host.core_cycles[1] < hal_host.core_cycles[0]
+                                        ? hal_host.core_cycles[1]
+                                        : hal_host.core_cycles[0];
+            if (run == RUN_ISA) {
+                isa_bus_run_until(behind);
+            } else {
+                // The board has been run up to the core that is ahead; reads wait for the other
+                retrace_run_until(behind < board.last_cycles ? behind : board.last_cycles, board.last_cycles,
+                                  board_settling());
+            }
+        }
+    }
+    hal_host_select_core(0);
+    if (run == RUN_IO) resolve_status_read();
+    board.loop_bursts_visible = board.bursts_visible;
+    bus_report("loop");
+
+    const uint64_t cycles = hal_host.cycles - start;
+    printf("  core 0 polls %llu, %.0f cycles/poll; core 1 polls %llu; CRTC R0=%u R1=%u R4=%u\n",
+           (unsigned long long) polls, polls ? (double) cycles / polls : 0.0, (unsigned long long) video_polls,
+           board.crtc.regs[0], board.crtc.regs[1], board.crtc.regs[4]);
+    printf("  vblank frames seen by core 1 %u, CRTC model frames %u; front page %u\n", cga_video_frames(),
+           board.crtc.frame, cga_video_page());
+    printf("  fetch  displayed addresses %llu, dropped %llu, bytes on time %llu, late %llu (%.2f%% lost)\n",
+           (unsigned long long) board.presented, (unsigned long long) board.dropped,
+           (unsigned long long) board.on_time, (unsigned long long) board.late,
+           board.presented ? 100.0 * (board.dropped + board.late) / board.presented : 0.0);
+}
+
+int main(int argc, char **argv) {
+    const char *command = argc > 1 ? argv[1] : "all";
+    const int frames = argc > 2 ? atoi(argv[2]) : 10;
+    const char *keys = argc > 3 ? argv[3] : NULL;
+    const bool all = !strcmp(command, "all");
+
+    if (!strcmp(command, "replay") || all) {
+        const uint64_t overhead = timer_overhead_ns();
+        printf("CGA fetch path replay, %d frame(s) per mode, timer overhead %llu ns\n", frames,
+               (unsigned long long) overhead);
+        bool ok = true;
+        for (int mode = 0; mode < VIDEO_MODE_COUNT; mode++) {
+            ok &= replay_mode(video_mode_desc(mode), frames, overhead);
+        }
+        if (!all) return ok ? 0 : 1;
+        run_firmware(frames, keys, RUN_KEYS);
+        return ok && !board.loop_bursts_visible ? 0 : 1;
+    }
+    if (!strcmp(command, "bus")) {
+        run_firmware(frames, keys, RUN_KEYS);
+        return board.loop_bursts_visible ? 1 : 0;
+    }
+    if (!strcmp(command, "upload")) {
+        // A few frames more than are streamed, for the last flip to land
+        upload_link_init(frames, keys ? atoi(keys) : -1, argc > 4 && !strcmp(argv[4], "delta"));
+        run_firmware(frames + 10, NULL, RUN_UPLOAD);
+        return upload_link_report() ? 0 : 1;
+    }
+    if (!strcmp(command, "delta")) {
+        return delta_bench(frames > 0 ? frames : 1) ? 0 : 1;
+    }
+    if (!strcmp(command, "isa")) {
+        bool ok = isa_bus_decode_check();
+        if (CGA_ISA_VRAM) {
+            run_firmware(frames > 0 ? frames : 1, NULL, RUN_ISA);
+            ok &= isa_bus_report();
+        } else {
+            printf("bus cycles need the ISA window board: -DCGA_FETCH_DMA=OFF -DCGA_ISA_VRAM=ON\n");
+        }
+        return ok ? 0 : 1;
+    }
+    if (!strcmp(command, "retrace")) {
+        run_firmware(argc > 2 ? frames : 40, keys ? keys : "tg", RUN_RETRACE);
+        return retrace_report() ? 0 : 1;
+    }
+    if (!strcmp(command, "modes")) {
+        return mode_check() ? 0 : 1;
+    }
+    if (!strcmp(command, "kernels")) {
+        return kernel_bench(argc > 2 && frames > 0 ? frames : 200) ? 0 : 1;
+    }
+    if (!strcmp(command, "io")) {
+        io_ports_init();
+        run_firmware(0, NULL, RUN_IO);
+        return io_ports_report(&board.crtc, board.dropped + board.late) ? 0 : 1;
+    }
+    fprintf(stderr, "usage: cga_sim [all|replay|bus|upload|delta|isa|retrace|io|modes|kernels] [frames] [keys]\n");
+    return 2;
+}
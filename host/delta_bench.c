@@ -0,0 +1,219 @@
+#include "delta_bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "delta_codec.h"
+#include "upload_protocol.h"
+#include "video_memory.h"
+
+#define PACKET_OVERHEAD (UPLOAD_HEADER_SIZE + UPLOAD_CRC_SIZE)
+
+typedef struct {
+    const char *name;
+    bool text;
+    void (*render)(uint8_t *window, uint32_t frame);
+} workload_t;
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// ---------------- Text UI: menu, scrolling log, status line ----------------
+
+static void text_print(uint8_t *window, const int row, const int col, const uint8_t attr, const char *s) {
+    for (int c = col; *s && c < 80; c++, s++) {
+        window[2 * (row * 80 + c)] = (uint8_t) *s;
+        window[2 * (row * 80 + c) + 1] = attr;
+    }
+}
+
+static void render_text_ui(uint8_t *window, const uint32_t frame) {
+    char line[81];
+    for (int cell = 0; cell < TEXT_BUFFER_SIZE; cell++) {
+        window[2 * cell] = ' ';
+        window[2 * cell + 1] = 0x1F;
+    }
+    text_print(window, 0, 0, 0x70, " File  Edit  View  Tools  Help");
+    for (int row = 2; row < 24; row++) {
+        text_print(window, row, 23, 0x1B, "\xB3");
+    }
+    // Selection moves every quarter second
+    for (int item = 0; item < 10; item++) {
+        snprintf(line, sizeof(line), " Menu entry %-8d ", item + 1);
+        text_print(window, 3 + item * 2, 1, item == (int) (frame / 15 % 10) ? 0x2F : 0x1E, line);
+    }
+    // A log line every 20 frames, the pane scrolls
+    const uint32_t newest = frame / 20;
+    for (int row = 0; row < 21; row++) {
+        if (newest < (uint32_t) (20 - row)) continue;
+        const uint32_t n = newest - (20 - row);
+        snprintf(line, sizeof(line), "%05u  request %u handled in %u ms", n, n * 7 % 1000, n * 13 % 97);
+        text_print(window, 2 + row, 25, 0x17, line);
+    }
+    // Clock on the status line, every frame
+    snprintf(line, sizeof(line), " Ready %c   %02u:%02u.%02u   frame %-8u", "|/-\\"[frame / 4 % 4],
+             frame / 3600 % 60, frame / 60 % 60, frame % 60 * 100 / 60, frame);
+    text_print(window, 24, 0, 0x70, line);
+    text_print(window, 24, 40, 0x70, "                                        ");
+}
+
+// ---------------- 320x200 games ----------------
+
+static void put_pixel(uint8_t *window, const int x, const int y, const uint8_t color) {
+    if (x < 0 || x >= 320 || y < 0 || y >= 200) return;
+    uint8_t *byte = &window[(y & 1) << GRAPHICS_INDEX_BITS | ((y >> 1) * 80 + x / 4)];
+    const int shift = 6 - 2 * (x & 3);
+    *byte = (uint8_t) ((*byte & ~(3 << shift)) | color << shift);
+}
+
+static void render_background(uint8_t *window, const int scroll) {
+    for (int y = 0; y < 200; y++) {
+        for (int x = 0; x < 320; x++) {
+            const int wx = x + scroll;
+            uint8_t color = 0;
+            if (y >= 160) color = (wx / 8 + y / 8) & 1 ? 1 : 2; // Checkered ground
+            else if (y >= 140 - (wx / 32 % 4) * 10) color = 1; // Hills
+            else if ((wx * 7 + y * 13) % 97 == 0) color = 3;   // Stars
+            put_pixel(window, x, y, color);
+        }
+    }
+}
+
+static void render_sprites(uint8_t *window, const uint32_t frame) {
+    for (int s = 0; s < 8; s++) {
+        // Bounce inside the screen
+        const int span_x = 320 - 16, span_y = 200 - 16;
+        int x = (int) ((s * 41 + frame * (1 + s % 3)) % (2 * span_x));
+        int y = (int) ((s * 23 + frame * (1 + s % 2)) % (2 * span_y));
+        if (x >= span_x) x = 2 * span_x - x;
+        if (y >= span_y) y = 2 * span_y - y;
+        for (int dy = 0; dy < 16; dy++) {
+            for (int dx = 0; dx < 16; dx++) {
+                const int cx = 2 * dx - 15, cy = 2 * dy - 15;
+                if (cx * cx + cy * cy <= 225) put_pixel(window, x + dx, y + dy, dx == 5 || dy == 5 ? 1 : 3);
+            }
+        }
+    }
+    // Score counter: 6 digits of 4x8 blocks
+    uint32_t score = frame * 10;
+    for (int d = 5; d >= 0; d--, score /= 10) {
+        for (int dy = 0; dy < 8; dy++) {
+            for (int dx = 0; dx < 4; dx++) {
+                put_pixel(window, 8 + d * 6 + dx, 4 + dy, (score % 10 >> (dy / 2 % 4) & 1) ? 3 : 0);
+            }
+        }
+    }
+}
+
+static void render_sprites_game(uint8_t *window, const uint32_t frame) {
+    render_background(window, 0);
+    render_sprites(window, frame);
+}
+
+static void render_scrolling_game(uint8_t *window, const uint32_t frame) {
+    render_background(window, (int) frame);
+    render_sprites(window, frame);
+}
+
+static const workload_t workloads[] = {
+    {"text UI 80x25", true, render_text_ui},
+    {"sprites 320x200", false, render_sprites_game},
+    {"scrolling 320x200", false, render_scrolling_game},
+};
+
+// Everything the firmware shows of a text page must match the frame, row planes included
+static bool text_page_matches(const uint8_t page, const uint8_t *frame) {
+    if (memcmp(text_buffer[page], frame, TEXT_WINDOW_BYTES)) return false;
+    const video_font_t *font = &video_page_font[page];
+    for (int cell = 0; cell < (1 << TEXT_INDEX_BITS); cell++) {
+        const uint8_t ch = frame[2 * cell], attr = frame[2 * cell + 1];
+        for (int row = 0; row < (1 << TEXT_ROW_BITS); row++) {
+            if (text_rows[page][row][cell] != (font->glyphs[ch * font->rows + row] | attr << 8)) return false;
+        }
+    }
+    return true;
+}
+
+static bool bench_workload(const workload_t *w, const uint32_t frames) {
+    static uint8_t frame[GRAPHICS_WINDOW_BYTES], prev[GRAPHICS_WINDOW_BYTES];
+    uint8_t stream[UPLOAD_MAX_PAYLOAD];
+    const uint32_t size = w->text ? TEXT_WINDOW_BYTES : GRAPHICS_WINDOW_BYTES;
+
+    // Full frame upload as upload_link.c sends it: the displayed bytes plus FLIP
+    const uint32_t raw_bytes = w->text ? 2 * TEXT_BUFFER_SIZE : 2 * GRAPHICS_BUFFER_SIZE;
+    const uint32_t raw_packets = (w->text ? 1 : 2 * ((GRAPHICS_BUFFER_SIZE + UPLOAD_MAX_PAYLOAD - 1) / UPLOAD_MAX_PAYLOAD)) + 1;
+    const uint32_t raw_wire = raw_bytes + raw_packets * PACKET_OVERHEAD;
+
+    // Both pages start out as frame 0, sent in full
+    memset(frame, 0, sizeof(frame));
+    w->render(frame, 0);
+    for (int page = VIDEO_PAGES - 1; page >= 0; page--) {
+        video_back_page = page;
+        if (w->text) video_text_write(0, frame, TEXT_WINDOW_BYTES);
+        else video_graphics_write(0, frame, GRAPHICS_WINDOW_BYTES);
+    }
+    video_back_page = 1;
+    memcpy(prev, frame, size);
+
+    uint64_t wire = 0, wire_max = 0, packets = 0, encode_ns = 0, apply_ns = 0, apply_max = 0;
+    uint32_t mismatches = 0, rejected = 0;
+    for (uint32_t n = 1; n <= frames; n++) {
+        memcpy(frame, prev, size);
+        w->render(frame, n);
+
+        uint64_t frame_wire = PACKET_OVERHEAD, frame_apply = 0; // FLIP
+        uint32_t start = 0, end;
+        while (true) {
+            const uint64_t t0 = now_ns();
+            const size_t length = delta_encode(stream, sizeof(stream), prev, frame, size, &start, &end);
+            const uint64_t t1 = now_ns();
+            encode_ns += t1 - t0;
+            if (!length) break;
+
+            frame_wire += length + PACKET_OVERHEAD;
+            packets++;
+            const bool applied = w->text ? video_text_delta(start, stream, length)
+                                         : video_graphics_delta(start, stream, length);
+            frame_apply += now_ns() - t1;
+            rejected += !applied;
+            start = end;
+        }
+        const uint64_t t2 = now_ns();
+        video_delta_finish();
+        frame_apply += now_ns() - t2;
+
+        mismatches += w->text ? !text_page_matches(video_back_page, frame)
+                              : memcmp(graphics_buffer[video_back_page], frame, size) != 0;
+        video_back_page ^= 1;
+        memcpy(prev, frame, size);
+
+        wire += frame_wire;
+        if (frame_wire > wire_max) wire_max = frame_wire;
+        apply_ns += frame_apply;
+        if (frame_apply > apply_max) apply_max = frame_apply;
+    }
+
+    const double avg = (double) wire / frames;
+    printf("%-18s frames %u, full upload %u B/frame, delta avg %.0f max %llu B/frame (%.1f%%), %.1f packets/frame\n",
+           w->name, frames, raw_wire, avg, (unsigned long long) wire_max, 100.0 * avg / raw_wire,
+           (double) packets / frames);
+    printf("  at 60 fps %.0f KB/s instead of %.0f KB/s; host encode %.1f us/frame, apply avg/max %.1f/%.1f us/frame\n",
+           avg * 60 / 1000, raw_wire * 60.0 / 1000, encode_ns / 1e3 / frames, apply_ns / 1e3 / frames,
+           apply_max / 1e3);
+    printf("  rejected packets %u, pages differing from the frame %u\n", rejected, mismatches);
+    return !rejected && !mismatches;
+}
+
+bool delta_bench(const uint32_t frames) {
+    printf("Delta streaming, %u frame(s) per workload after a full first frame\n", frames);
+    video_memory_init();
+    bool ok = true;
+    for (unsigned i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+        ok &= bench_workload(&workloads[i], frames);
+    }
+    return ok;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Delta streaming benchmark for cga_sim: renders typical workloads frame by frame,
+// encodes each frame against the previous one (delta_codec.h), packs the streams into
+// upload_protocol.h packets and applies them with the firmware's own video_*_delta()
+// on the real page buffers, as handle_packet() would between two flips.
+// Reports bytes on the wire against full-frame uploads, host encode and apply time,
+// and checks every back page (and the text row planes) against the rendered frame.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// false if any applied frame differs from the rendered one
+bool delta_bench(uint32_t frames);
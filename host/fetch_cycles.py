@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+"""Cycle estimate of the assembly fetch loop (video_fetch.S) against every video mode.
+
+Expands each FETCH_SERVE of video_fetch.S the way the assembler does, checks its
+layout widths against the VIDEO_LAYOUT_* traits of video_memory.h and counts
+Cortex-M0+ cycles along its two paths: a sample waiting (FSTAT read through the
+branch back) and an empty FIFO (FSTAT read through the return). For every mode of
+video_registry.c that runs the loop, at the mode's DOTCLK and SYSTEM_CLOCK_HZ:
+
+  per fetch    one pass, must fit the character clock (DOTCLK / 8)
+  latency      a sample captured just after an FSTAT read: the rest of that pass and
+               the FSTAT-to-TXF path of the next, must be out before video_data pulls,
+               VIDEO_DATA_LATENCY DOTCLKs after the capture
+  slack        what is left of that deadline for the rest of a cga_video_poll() pass
+
+  python3 host/fetch_cycles.py [--root DIR] [--io-wait N]
+
+--io-wait adds N cycles to every PIO register access (bus contention, e.g. the ISA
+read chains' DMA). Exit status 1 if a mode misses its budget or the traits disagree.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# Cortex-M0+ (ARM DDI 0484C, table 3-1) with the RP2040's zero-wait SRAM
+CYCLES = {
+    'adds': 1, 'subs': 1, 'ands': 1, 'orrs': 1, 'eors': 1, 'lsls': 1, 'lsrs': 1, 'asrs': 1,
+    'movs': 1, 'mov': 1, 'cmp': 1, 'tst': 1, 'muls': 1, 'uxth': 1, 'uxtb': 1,
+    'ldr': 2, 'ldrh': 2, 'ldrb': 2, 'str': 2, 'strh': 2, 'strb': 2,
+    'b': 2, 'bx': 2, 'bl': 3,
+}
+BRANCH_NOT_TAKEN = 1
+PIO_BASE_REG = 'r1'
+
+
+def read(root, name):
+    with open(os.path.join(root, name)) as f:
+        return f.read()
+
+
+def defines(text):
+    return dict(re.findall(r'^#define\s+(\w+)\s+(.+?)\s*(?://.*)?$', text, re.M))
+
+
+def evaluate(expr, names):
+    for _ in range(8):
+        expr = re.sub(r'\b[A-Za-z_]\w*\b', lambda m: str(names.get(m.group(0), m.group(0))), expr)
+    return eval(expr, {'__builtins__': {}})
+
+
+def layouts(root):
+    """VIDEO_LAYOUT_<X> -> (ma_bits, row_bits, entry_shift)"""
+    names = defines(read(root, 'video_memory.h'))
+    result = {}
+    for key, value in names.items():
+        if key.startswith('VIDEO_LAYOUT_'):
+            table, ma, row, entry = [v.strip() for v in value.split(',')]
+            result[key[len('VIDEO_LAYOUT_'):].lower()] = (
+                evaluate(ma, names), evaluate(row, names), {'uint16_t': 1, 'uint8_t': 0}[entry])
+    return result
+
+
+def modes(root):
+    """(name, DOTCLK Hz, loop) per registry entry"""
+    names = defines(read(root, 'board.h'))
+    names['MHZ'] = 1000000
+    result = []
+    for body in re.findall(r'\[VIDEO_MODE_\w+\]\s*=\s*\{(.*?)\n    \}', read(root, 'video_registry.c'), re.S):
+        name = re.search(r'\.name\s*=\s*"([^"]+)"', body).group(1)
+        clock = evaluate(re.search(r'\bDOTCLK\((\w+)\)', body).group(1), names)
+        loop = re.search(r'FETCH_LOOP\((\w+)\)', body)
+        result.append((name, clock, loop.group(1) if loop else None))
+    return result, evaluate('SYSTEM_CLOCK_HZ', names)
+
+
+def expand(source):
+    """name -> (args, instruction list) for every FETCH_SERVE invocation"""
+    macro = re.search(r'^\.macro\s+FETCH_SERVE\s+(.*?)\n(.*?)^\.endm', source, re.M | re.S)
+    params = [p.strip() for p in macro.group(1).split(',')]
+    result = {}
+    for call in re.findall(r'^FETCH_SERVE\s+(.*)$', source, re.M):
+        args = [a.strip() for a in call.split(',')]
+        values = dict(zip(params, args))
+        lines, stack = [], []
+        for raw in macro.group(2).split('\n'):
+            line = raw.split('//')[0].strip()
+            line = line.replace('\\()', '')
+            for p in params:
+                line = line.replace('\\' + p, values[p])
+            if not line:
+                continue
+            if line.startswith('.if'):
+                stack.append(bool(evaluate(line[3:], {})))
+            elif line == '.else':
+                stack[-1] = not stack[-1]
+            elif line == '.endif':
+                stack.pop()
+            elif all(stack):
+                lines.append(line)
+        result[args[0]] = ([int(a) for a in args[1:]], lines)
+    return result
+
+
+def instructions(lines):
+    """[(label or None, mnemonic, operands)]"""
+    result, label = [], None
+    for line in lines:
+        if line.endswith(':'):
+            label = line[:-1]
+        elif not line.startswith('.'):
+            mnemonic, _, operands = line.partition(' ')
+            result.append((label, mnemonic, operands.strip()))
+            label = None
+    return result
+
+
+def conditional(mnemonic):
+    return mnemonic.startswith('b') and mnemonic not in CYCLES
+
+
+def pio_access(mnemonic, operands):
+    return mnemonic.startswith(('ldr', 'str')) and re.search(rf'\[\s*{PIO_BASE_REG}\b', operands)
+
+
+def cost(mnemonic, operands, taken, io_wait):
+    if conditional(mnemonic):
+        return CYCLES['b'] if taken else BRANCH_NOT_TAKEN
+    if mnemonic not in CYCLES:
+        sys.exit(f'fetch_cycles: no cycle count for {mnemonic}')
+    return CYCLES[mnemonic] + (io_wait if pio_access(mnemonic, operands) else 0)
+
+
+def paths(program, io_wait):
+    """(per fetch, FSTAT to TXF, empty FIFO) cycles"""
+    loop = latency = 0
+    for _, mnemonic, operands in program:
+        if mnemonic == 'b':
+            loop += cost(mnemonic, operands, True, io_wait)
+            break
+        loop += cost(mnemonic, operands, False, io_wait)
+        if mnemonic.startswith('str') and pio_access(mnemonic, operands):
+            latency = loop  # The pair is in the TX FIFO
+    # FIFO empty: FSTAT read, the exit branch taken, the return
+    empty = 0
+    for _, mnemonic, operands in program:
+        if conditional(mnemonic):
+            empty += cost(mnemonic, operands, True, io_wait)
+            break
+        empty += cost(mnemonic, operands, False, io_wait)
+    empty += cost('bx', 'lr', True, io_wait)
+    if not latency:
+        sys.exit('fetch_cycles: no TXF write in the loop')
+    return loop, latency, empty
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--root', default=os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+    parser.add_argument('--io-wait', type=int, default=0)
+    args = parser.parse_args()
+
+    source = read(args.root, 'video_fetch.S')
+    traits = layouts(args.root)
+    loops = expand(source)
+    data_latency = evaluate('VIDEO_DATA_LATENCY', defines(read(args.root, 'video_pio.h')))
+    mode_list, sys_hz = modes(args.root)
+
+    ok = True
+    timing = {}
+    print(f'video_fetch.S at {sys_hz / 1e6:.0f} MHz, PIO accesses +{args.io_wait} cycles')
+    for name, (widths, lines) in loops.items():
+        layout = name[len('video_fetch_loop_'):]
+        if traits.get(layout) != tuple(widths):
+            print(f'  {name}: widths {tuple(widths)}, VIDEO_LAYOUT_{layout.upper()} is {traits.get(layout)}: WRONG')
+            ok = False
+        timing[name] = paths(instructions(lines), args.io_wait)
+        loop, latency, empty = timing[name]
+        print(f'  {name:26} {loop:3} cycles/fetch, FSTAT to TXF {latency:3}, empty FIFO {empty:3}')
+
+    for name, clock, loop_name in mode_list:
+        if loop_name is None:
+            continue
+        if loop_name not in timing:
+            print(f'  {name}: {loop_name} is not in video_fetch.S: WRONG')
+            ok = False
+            continue
+        loop, latency, _ = timing[loop_name]
+        budget = sys_hz * 8 / clock
+        deadline = sys_hz * data_latency / clock
+        worst = loop + latency
+        fits = loop <= budget and worst <= deadline
+        ok &= fits
+        print(f'  {name:17} {clock / 1e6:8.5f} MHz: {loop:3} of {budget:5.1f} cycles/char, worst latency {worst:3} '
+              f'of {deadline:5.1f} ({data_latency} DOTCLKs), slack {deadline - worst:5.1f}: {"ok" if fits else "WRONG"}')
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
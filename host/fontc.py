@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Font compiler: raw glyph dumps (.bin, 256 glyphs of 8 one-byte rows, [char][row],
+MSB = leftmost pixel) or a C array like rom.h, into what the firmware and
+the board want.
+
+  --header OUT --name NAME   C array of the first font, as rom.h
+  --flash OUT [--select N]   image of the flash font partition (video_memory.h): every
+                             font in slot order, one slot each
+  --lsb-first                bit-reverse every row, for a shift register that sends
+                             D0 first
+  --layout row-char          [row][char] instead of [char][row] for --header: one
+                             256-byte table per glyph row, indexed by the character
+
+The firmware expands [char][row] glyphs into its row planes (video_memory.h), so that
+is what the flash image holds and what CMake asks for; row-char is for fetch paths
+that index glyph memory with RA directly. 8x14 and 8x16 dumps are refused: the board
+brings RA0..RA2 out only, so the firmware has 8 row planes (FONT_ROWS).
+
+  python3 host/fontc.py CGA_PRAVETZ__8x8.bin --header font_rom.h --name cga_font_8x8
+  python3 host/fontc.py rom.h CGA_PRAVETZ__8x8.bin --flash fonts.bin --select 1
+"""
+
+import argparse
+import re
+import sys
+
+GLYPHS = 256
+SLOT_BYTES = 2048  # FONT_SLOT_BYTES
+SLOTS = 4          # FONT_SLOTS
+FLASH_MAGIC = b'CGFS'
+ROWS = {8 * GLYPHS: 8}  # FONT_ROWS
+
+
+def load(path):
+    if path.endswith('.h') or path.endswith('.c'):
+        with open(path) as f:
+            data = bytes(int(v, 16) for v in re.findall(r'0x([0-9a-fA-F]{2})\b', f.read()))
+    else:
+        with open(path, 'rb') as f:
+            data = f.read()
+    if len(data) not in ROWS:
+        sys.exit(f'{path}: {len(data)} bytes, not 256 glyphs of 8 rows')
+    return data, ROWS[len(data)]
+
+
+def reverse_bits(data):
+    return bytes(int(f'{b:08b}'[::-1], 2) for b in data)
+
+
+def row_char(data, rows):
+    return bytes(data[ch * rows + row] for row in range(rows) for ch in range(GLYPHS))
+
+
+def write_header(path, name, data, source, layout, lsb_first):
+    lines = [f'// Generated by host/fontc.py from {source}: {layout}, '
+             f'{"LSB" if lsb_first else "MSB"} first']
+    lines.append(f'const uint8_t {name}[{len(data)}] = {{')
+    for i in range(0, len(data), 12):
+        lines.append('  ' + ' '.join(f'0x{b:02x},' for b in data[i:i + 12]))
+    lines[-1] = lines[-1].rstrip(',')
+    lines.append('};')
+    with open(path, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+def write_flash(path, fonts, select):
+    image = bytearray()
+    first_slot = []
+    for data, rows in fonts:
+        first_slot.append(len(image) // SLOT_BYTES)
+        image += data
+        image += b'\xff' * (-len(image) % SLOT_BYTES)
+    slots = len(image) // SLOT_BYTES
+    if slots > SLOTS:
+        sys.exit(f'{slots} slots needed, the firmware has {SLOTS}')
+    header = FLASH_MAGIC + bytes([slots, first_slot[select], fonts[select][1], 0])
+    with open(path, 'wb') as f:
+        f.write(header + image)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('fonts', nargs='+')
+    parser.add_argument('--header')
+    parser.add_argument('--name', default='cga_font_8x8')
+    parser.add_argument('--flash')
+    parser.add_argument('--select', type=int, default=0, help='font shown from boot (--flash)')
+    parser.add_argument('--lsb-first', action='store_true')
+    parser.add_argument('--layout', choices=['char-row', 'row-char'], default='char-row')
+    args = parser.parse_args()
+
+    fonts = []
+    for path in args.fonts:
+        data, rows = load(path)
+        fonts.append((reverse_bits(data) if args.lsb_first else data, rows))
+    if args.header:
+        data, rows = fonts[0]
+        if args.layout == 'row-char':
+            data = row_char(data, rows)
+        write_header(args.header, args.name, data, args.fonts[0], args.layout, args.lsb_first)
+    if args.flash:
+        if not 0 <= args.select < len(fonts):
+            sys.exit(f'--select {args.select}: {len(fonts)} font(s) given')
+        write_flash(args.flash, fonts, args.select)
+
+
+if __name__ == '__main__':
+    main()
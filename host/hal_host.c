@@ -0,0 +1,439 @@
+#include "hal.h"
+
+#include <string.h>
+
+hal_host_t hal_host;
+
+void hal_host_reset(const uint32_t sys_hz) {
+    memset(&hal_host, 0, sizeof(hal_host));
+    hal_host.sys_hz = sys_hz;
+}
+
+void hal_host_spend(const uint64_t cycles) {
+    hal_host.cycles += cycles;
+}
+
+void hal_host_select_core(const uint32_t core) {
+    hal_host.core_cycles[hal_host.core] = hal_host.cycles;
+    hal_host.core = core;
+    hal_host.cycles = hal_host.core_cycles[core];
+}
+
+// Let the harness bring the rest of the board up to the current virtual time
+static void crtc_run(void);
+
+static void sync(void) {
+    crtc_run();
+    if (hal_host.on_input) {
+        hal_host.on_input();
+    }
+}
+
+static void drive(const uint32_t out, const uint32_t oe) {
+    const uint32_t prev = hal_host.out & hal_host.oe;
+    hal_host.out = out;
+    hal_host.oe = oe;
+    hal_host.cycles += HAL_HOST_SIO_CYCLES;
+    const uint32_t now = hal_host.out & hal_host.oe;
+    if (now != prev && hal_host.on_output) {
+        hal_host.on_output(prev, now);
+    }
+}
+
+void hal_system_init(const uint32_t sys_hz) {
+    hal_host.sys_hz = sys_hz;
+}
+
+void hal_gpio_init(const uint32_t pin) {
+    drive(hal_host.out & ~(1u << pin), hal_host.oe & ~(1u << pin));
+}
+
+void hal_gpio_set_dir(const uint32_t pin, const bool out) {
+    const uint32_t bit = 1u << pin;
+    drive(hal_host.out, out ? hal_host.oe | bit : hal_host.oe & ~bit);
+}
+
+void hal_gpio_set_dir_masked(const uint32_t mask, const uint32_t value) {
+    drive(hal_host.out, (hal_host.oe & ~mask) | (value & mask));
+}
+
+void hal_gpio_put(const uint32_t pin, const bool value) {
+    const uint32_t bit = 1u << pin;
+    drive(value ? hal_host.out | bit : hal_host.out & ~bit, hal_host.oe);
+}
+
+void hal_gpio_put_masked(const uint32_t mask, const uint32_t value) {
+    drive((hal_host.out & ~mask) | (value & mask), hal_host.oe);
+}
+
+uint32_t hal_gpio_get_all(void) {
+    hal_host.cycles += HAL_HOST_SIO_CYCLES;
+    sync();
+    return (hal_host.in & ~hal_host.oe) | (hal_host.out & hal_host.oe);
+}
+
+void hal_sleep_us(const uint64_t us) {
+    hal_host.cycles += us * (hal_host.sys_hz / MHZ);
+}
+
+void hal_busy_wait_ms(const uint32_t ms) {
+    hal_host.cycles += (uint64_t) ms * (hal_host.sys_hz / KHZ);
+}
+
+void hal_busy_wait_cycles(const uint32_t cycles) {
+    hal_host.cycles += cycles;
+}
+
+void hal_core1_launch(void (*entry)(void)) {
+    // Core 1 starts at the launching core's "now"
+    hal_host.core_cycles[1] = hal_host.cycles;
+    hal_host.core1_entry = entry;
+}
+
+void hal_interrupts_disable(void) {
+}
+
+void hal_clock_init(const uint32_t pin, const float freq) {
+    (void) pin;
+    // The SDK truncates the divider to 16.8 as DOTCLK() does, two SM cycles per DOTCLK
+    hal_clock_set_div((uint32_t) (hal_host.sys_hz * 128.0 / freq));
+}
+
+void hal_clock_set_div(const uint32_t div) {
+    // The status engine counts DOTCLKs: up to here at the old rate
+    hal_host_raster_run(hal_host.cycles);
+    hal_host.clock_freq = (float) (hal_host.sys_hz * 128.0 / div); // Two SM cycles per DOTCLK
+}
+
+uint32_t hal_console_read(uint8_t *buf, const uint32_t max) {
+    hal_host.cycles += HAL_HOST_GETCHAR_CYCLES;
+    const uint32_t count = hal_host.console_read ? hal_host.console_read(buf, max) : 0;
+    hal_host.cycles += (uint64_t) count * HAL_HOST_CONSOLE_BYTE_CYCLES;
+    return count;
+}
+
+void hal_console_write(const uint8_t *buf, const uint32_t len) {
+    hal_host.cycles += HAL_HOST_GETCHAR_CYCLES + (uint64_t) len * HAL_HOST_CONSOLE_BYTE_CYCLES;
+    if (hal_host.console_write) {
+        hal_host.console_write(buf, len);
+    }
+}
+
+uint64_t hal_time_us(void) {
+    return (uint64_t) hal_host_time_us();
+}
+
+void hal_flash_read(const uint32_t offset, void *buf, const uint32_t len) {
+    // Erased unless the harness has put an image there
+    memset(buf, 0xFF, len);
+    if (offset < hal_host.flash_size) {
+        const uint32_t n = hal_host.flash_size - offset < len ? hal_host.flash_size - offset : len;
+        memcpy(buf, hal_host.flash + offset, n);
+    }
+    hal_host.cycles += (uint64_t) len * HAL_HOST_FLASH_BYTE_CYCLES;
+}
+
+// ---------------- PIO video fetch engine ----------------
+
+bool hal_host_video_capture(const uint32_t sample) {
+    if (!hal_host.video_running) {
+        return false;
+    }
+    if (hal_host.video_dma) {
+        // The chain completes well inside the output latency and costs no CPU time
+        if (hal_host.tx_count < HAL_HOST_FIFO_DEPTH) {
+            hal_host.tx_fifo[hal_host.tx_count++] = video_dma_lookup(&hal_host.dma_layout, sample);
+        }
+        return true;
+    }
+    if (hal_host.rx_count == 2 * HAL_HOST_FIFO_DEPTH) {
+        return false;
+    }
+    hal_host.rx_fifo[(hal_host.rx_head + hal_host.rx_count++) % (2 * HAL_HOST_FIFO_DEPTH)] = sample;
+    return true;
+}
+
+bool hal_host_video_output(uint16_t *value) {
+    const bool on_time = hal_host.tx_count != 0;
+    if (on_time) {
+        hal_host.tx_last = hal_host.tx_fifo[hal_host.tx_count - 1];
+        hal_host.tx_count = 0;
+    }
+    *value = hal_host.tx_last;
+    return on_time;
+}
+
+void hal_video_init(const uint32_t addr_pin_base, const uint32_t data_pin_base) {
+    (void) addr_pin_base;
+    (void) data_pin_base;
+    hal_host.video_running = true;
+}
+
+bool hal_video_addr_pending(void) {
+    hal_host.cycles += HAL_HOST_FIFO_CYCLES;
+    sync();
+    return hal_host.rx_count != 0;
+}
+
+uint32_t hal_video_addr_get(void) {
+    hal_host.cycles += HAL_HOST_FIFO_CYCLES;
+    if (!hal_host.rx_count) {
+        return 0;
+    }
+    const uint32_t sample = hal_host.rx_fifo[hal_host.rx_head];
+    hal_host.rx_head = (hal_host.rx_head + 1) % (2 * HAL_HOST_FIFO_DEPTH);
+    hal_host.rx_count--;
+    return sample;
+}
+
+void hal_video_data_put(const uint16_t value) {
+    hal_host.cycles += HAL_HOST_FIFO_CYCLES;
+    sync();
+    if (hal_host.tx_count < HAL_HOST_FIFO_DEPTH) {
+        hal_host.tx_fifo[hal_host.tx_count++] = value;
+    }
+}
+
+void hal_video_dma_init(const uint32_t addr_pin_base, const uint32_t data_pin_base, const video_dma_layout_t *layout) {
+    hal_video_init(addr_pin_base, data_pin_base);
+    hal_host.video_dma = true;
+    hal_host.dma_layout = *layout;
+}
+
+void hal_video_dma_set_layout(const video_dma_layout_t *layout) {
+    hal_host.dma_layout = *layout;
+    hal_host.tx_count = 0;
+}
+
+// ---------------- MC6845 register write engine ----------------
+
+// mc6845_bus.pio edges, in engine cycles from the pull: CS/RS/E levels and which byte is on D0..D7
+typedef struct {
+    uint8_t at, cs, rs, e, byte; // byte: 0 = register number, 1 = value
+} crtc_edge_t;
+
+static const crtc_edge_t crtc_edges[] = {
+    {1, 0, 0, 0, 0},  {3, 0, 0, 1, 0},  {7, 0, 0, 0, 0}, {9, 0, 1, 0, 1},
+    {11, 0, 1, 1, 1}, {15, 0, 1, 0, 1}, {16, 1, 1, 0, 1},
+};
+
+// Replay the engine's pin edges up to the running core's clock. The edges are driven
+// at their own time stamps and cost the CPU nothing.
+static void crtc_run(void) {
+    const uint64_t now = hal_host.cycles;
+    const uint32_t div = hal_host.sys_hz / HAL_HOST_CRTC_BUS_HZ;
+    while (hal_host.crtc_count) {
+        const crtc_edge_t *edge = &crtc_edges[hal_host.crtc_edge];
+        const uint64_t at = hal_host.crtc_start[0] + (uint64_t) edge->at * div;
+        if (at > now) break;
+
+        const uint32_t ctrl = hal_host.crtc_ctrl_pin_base, data = hal_host.crtc_data_pin_base;
+        const uint16_t entry = hal_host.crtc_fifo[0];
+        const uint32_t mask = 7u << ctrl | 0xFFu << data;
+        const uint32_t levels = (uint32_t) edge->cs << ctrl | (uint32_t) edge->rs << (ctrl + 1) |
+                                (uint32_t) edge->e << (ctrl + 2) |
+                                (uint32_t) (edge->byte ? entry >> 8 : entry & 0xFF) << data;
+        const uint32_t prev = hal_host.out & hal_host.oe;
+        hal_host.out = (hal_host.out & ~mask) | levels;
+        hal_host.cycles = at;
+        if ((hal_host.out & hal_host.oe) != prev && hal_host.on_output) {
+            hal_host.on_output(prev, hal_host.out & hal_host.oe);
+        }
+        hal_host.cycles = now;
+
+        if (++hal_host.crtc_edge == sizeof(crtc_edges) / sizeof(crtc_edges[0])) {
+            hal_host.crtc_edge = 0;
+            hal_host.crtc_count--;
+            for (uint32_t i = 0; i < hal_host.crtc_count; i++) {
+                hal_host.crtc_fifo[i] = hal_host.crtc_fifo[i + 1];
+                hal_host.crtc_start[i] = hal_host.crtc_start[i + 1];
+            }
+        }
+    }
+}
+
+void hal_crtc_write_init(const uint32_t ctrl_pin_base, const uint32_t data_pin_base) {
+    hal_host.crtc_ctrl_pin_base = ctrl_pin_base;
+    hal_host.crtc_data_pin_base = data_pin_base;
+    hal_host.crtc_count = hal_host.crtc_edge = 0;
+}
+
+bool hal_crtc_write_ready(void) {
+    hal_host.cycles += HAL_HOST_FIFO_CYCLES;
+    crtc_run();
+    // The write being clocked out has left the FIFO
+    uint32_t queued = 0;
+    for (uint32_t i = 0; i < hal_host.crtc_count; i++) {
+        if (hal_host.crtc_start[i] > hal_host.cycles) queued++;
+    }
+    return queued < HAL_HOST_CRTC_FIFO_DEPTH;
+}
+
+void hal_crtc_write(const uint8_t reg, const uint8_t value) {
+    hal_host.cycles += HAL_HOST_FIFO_CYCLES;
+    crtc_run();
+    if (hal_host.crtc_count > HAL_HOST_CRTC_FIFO_DEPTH) return;
+    const uint64_t start = hal_host.crtc_busy_until > hal_host.cycles ? hal_host.crtc_busy_until : hal_host.cycles;
+    if (start == hal_host.cycles) {
+        // Engine idle: the first write of a burst claims D0..D7
+        hal_host.crtc_burst_from[1] = hal_host.crtc_burst_from[0];
+        hal_host.crtc_burst_until[1] = hal_host.crtc_burst_until[0];
+        hal_host.crtc_burst_from[0] = start;
+    }
+    hal_host.crtc_fifo[hal_host.crtc_count] = reg | (uint16_t) value << 8;
+    hal_host.crtc_start[hal_host.crtc_count] = start;
+    hal_host.crtc_count++;
+    hal_host.crtc_busy_until =
+        start + (uint64_t) HAL_HOST_CRTC_WRITE_CYCLES * (hal_host.sys_hz / HAL_HOST_CRTC_BUS_HZ);
+    hal_host.crtc_burst_until[0] = hal_host.crtc_busy_until;
+}
+
+void hal_crtc_write_poll(void) {
+    hal_host.cycles += HAL_HOST_FIFO_CYCLES;
+    crtc_run();
+}
+
+bool hal_host_crtc_bus_claimed(const uint64_t at) {
+    for (int i = 0; i < 2; i++) {
+        if (at >= hal_host.crtc_burst_from[i] && at < hal_host.crtc_burst_until[i]) return true;
+    }
+    return false;
+}
+
+// ---------------- ISA memory window ----------------
+
+static bool isa_capture(const uint32_t sample, const uint64_t at) {
+    if (!hal_host.isa_running || hal_host.isa_count == HAL_HOST_ISA_FIFO_DEPTH) {
+        return false;
+    }
+    const uint32_t slot = (hal_host.isa_head + hal_host.isa_count++) % HAL_HOST_ISA_FIFO_DEPTH;
+    hal_host.isa_fifo[slot] = sample;
+    hal_host.isa_captured[slot] = at;
+    return true;
+}
+
+bool hal_host_isa_write(const uint32_t address, const uint8_t value, const uint64_t at) {
+    return isa_capture((address & 0x3FFF) | (uint32_t) value << hal_host.isa_data_pin_base | 1u << hal_host.isa_oe_pin,
+                       at);
+}
+
+bool hal_host_isa_io_write(const uint16_t port, const uint8_t value, const uint64_t at) {
+    return isa_capture((port & 0x3FF) | (uint32_t) value << hal_host.isa_data_pin_base, at);
+}
+
+uint8_t hal_host_isa_read(const uint32_t address) {
+    return isa_vram_lookup(&hal_host.isa_window, address);
+}
+
+void hal_isa_vram_init(const uint32_t addr_pin_base, const uint32_t data_pin_base, const uint32_t oe_pin,
+                       const uint32_t wr_pin, const isa_vram_window_t *window) {
+    (void) addr_pin_base;
+    hal_gpio_init(oe_pin);
+    hal_gpio_init(wr_pin);
+    hal_host.isa_running = true;
+    hal_host.isa_data_pin_base = data_pin_base;
+    hal_host.isa_oe_pin = oe_pin;
+    hal_host.isa_window = *window;
+    hal_host.isa_count = 0;
+}
+
+void hal_isa_vram_set_window(const isa_vram_window_t *window) {
+    hal_host.isa_window = *window;
+}
+
+bool hal_isa_vram_write_pending(void) {
+    hal_host.cycles += HAL_HOST_FIFO_CYCLES;
+    sync();
+    // A write the bus master has issued ahead of this core's clock is not captured yet
+    return hal_host.isa_count && hal_host.isa_captured[hal_host.isa_head] <= hal_host.cycles;
+}
+
+uint32_t hal_isa_vram_write_get(void) {
+    hal_host.cycles += HAL_HOST_FIFO_CYCLES;
+    if (!hal_host.isa_count) {
+        return 0;
+    }
+    const uint32_t sample = hal_host.isa_fifo[hal_host.isa_head];
+    const uint64_t captured = hal_host.isa_captured[hal_host.isa_head];
+    hal_host.isa_head = (hal_host.isa_head + 1) % HAL_HOST_ISA_FIFO_DEPTH;
+    hal_host.isa_count--;
+    if (hal_host.on_isa_write_taken) {
+        hal_host.on_isa_write_taken(sample, captured);
+    }
+    return sample;
+}
+
+// ---------------- 3DAh status engine ----------------
+
+static void raster_load(void) {
+    const uint32_t run = hal_host.raster_timeline[hal_host.raster_index];
+    *hal_host.raster_target = run & 0xFF;
+    hal_host.raster_left += (run >> 8) + 1;
+}
+
+void hal_host_raster_run(const uint64_t at) {
+    if (!hal_host.raster_running || at <= hal_host.raster_at) {
+        return;
+    }
+    hal_host.raster_left -= (double) (at - hal_host.raster_at) * hal_host.clock_freq / hal_host.sys_hz;
+    hal_host.raster_at = at;
+    while (hal_host.raster_left <= 0) {
+        // The feed channel runs out and the reload starts the timeline over
+        hal_host.raster_index = (hal_host.raster_index + 1) % hal_host.raster_words;
+        raster_load();
+    }
+}
+
+void hal_host_raster_input(const uint32_t sample, const uint64_t at) {
+    // Once running the engine no longer looks at RA0; it is run up to the reads instead,
+    // which may be behind the board
+    const bool ra0 = sample >> hal_host.raster_ra0_pin & 1;
+    if (hal_host.raster_armed) {
+        if (!ra0) {
+            hal_host.raster_ra0_low = true;
+        } else if (hal_host.raster_ra0_low) {
+            hal_host.raster_armed = false;
+            hal_host.raster_running = true;
+            hal_host.raster_at = hal_host.raster_synced = at;
+            hal_host.raster_index = 0;
+            hal_host.raster_left = 0;
+            raster_load();
+        }
+    }
+}
+
+void hal_raster_init(const uint32_t ra0_pin, uint8_t *target) {
+    hal_host.raster_ra0_pin = ra0_pin;
+    hal_host.raster_target = target;
+    hal_host.raster_armed = hal_host.raster_running = false;
+}
+
+void hal_raster_start(const uint32_t *timeline, const uint32_t words) {
+    sync();
+    hal_host.raster_timeline = timeline;
+    hal_host.raster_words = words;
+    hal_host.raster_running = false;
+    hal_host.raster_armed = true;
+    hal_host.raster_ra0_low = !(hal_host.in >> hal_host.raster_ra0_pin & 1);
+    // Two channel aborts, the SM restart and the feed re-arm
+    hal_host.cycles += 12 * HAL_HOST_FIFO_CYCLES;
+}
+
+void hal_raster_stop(void) {
+    hal_host.raster_armed = hal_host.raster_running = false;
+    hal_host.cycles += 3 * HAL_HOST_FIFO_CYCLES;
+}
+
+void hal_raster_set_target(uint8_t *target) {
+    hal_host_raster_run(hal_host.cycles);
+    *target = *hal_host.raster_target;
+    hal_host.raster_target = target;
+    hal_host.cycles += 2 * HAL_HOST_FIFO_CYCLES;
+}
+
+uint8_t hal_raster_status(void) {
+    sync();
+    hal_host_raster_run(hal_host.cycles);
+    hal_host.cycles += HAL_HOST_SIO_CYCLES;
+    return *hal_host.raster_target;
+}
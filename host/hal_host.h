@@ -0,0 +1,181 @@
+#pragma once
+
+// Host backend of hal.h: a simulated RP2040 pin bank plus virtual time.
+// Every HAL call charges an estimated number of sys_clk cycles to hal_host.cycles,
+// so a harness can read back how long the firmware spent on a bus transaction.
+// Each core has its own virtual clock; the harness runs whichever core is behind
+// and hal_host_select_core() swaps hal_host.cycles accordingly.
+// The harness plugs the rest of the board in through the two hooks:
+//   on_input  - called before every pin or FIFO access, e.g. to run the CRTC model up to "now"
+//   on_output - called after every change of the driven pin levels, e.g. to decode E strobes
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "isa_vram.h"
+#include "video_memory.h"
+
+#ifndef KHZ
+#define KHZ 1000
+#endif
+#ifndef MHZ
+#define MHZ 1000000
+#endif
+#ifndef __always_inline
+#define __always_inline inline __attribute__((__always_inline__))
+#endif
+#ifndef __not_in_flash_func
+#define __not_in_flash_func(name) name
+#endif
+
+// Estimated sys_clk cost of one SIO register access through the SDK helpers
+#define HAL_HOST_SIO_CYCLES 2
+// Estimated cost of a PIO FIFO access (APB register)
+#define HAL_HOST_FIFO_CYCLES 3
+// Estimated cost of polling the USB CDC console with nothing pending
+#define HAL_HOST_GETCHAR_CYCLES 400
+// Estimated cost per byte moved out of or into the CDC buffers
+#define HAL_HOST_CONSOLE_BYTE_CYCLES 2
+// Estimated cost per byte copied out of flash through XIP, cache cold
+#define HAL_HOST_FLASH_BYTE_CYCLES 8
+
+#define HAL_HOST_FIFO_DEPTH 4
+
+// MC6845 write engine, as in mc6845_bus_pio.h: joined TX FIFO, 16 cycles at 8 MHz per write
+#define HAL_HOST_CRTC_FIFO_DEPTH 8
+#define HAL_HOST_CRTC_BUS_HZ (8 * MHZ)
+#define HAL_HOST_CRTC_WRITE_CYCLES 16
+
+// ISA window write capture, as in isa_vram_pio.h: joined RX FIFO
+#define HAL_HOST_ISA_FIFO_DEPTH 8
+
+typedef struct {
+    uint32_t in;        // Levels driven into the RP2040 by the board
+    uint32_t out;       // SIO output latch
+    uint32_t oe;        // SIO output enable, 1 = output
+    uint32_t sys_hz;    // Virtual sys_clk
+    uint64_t cycles;    // Virtual sys_clk cycles since reset, of the running core
+    uint32_t core;      // Core the firmware is currently running on
+    uint64_t core_cycles[2];
+    void (*core1_entry)(void); // Set by hal_core1_launch(); the harness polls instead
+    float clock_freq;   // PIO clock generator output, 0 = stopped
+    const uint8_t *flash; // Flash contents from offset 0 as the harness sets them, else erased
+    uint32_t flash_size;
+
+    // PIO video engine: RX is joined (8 deep) as in video_pio.h
+    bool video_running;
+    uint32_t rx_fifo[2 * HAL_HOST_FIFO_DEPTH];
+    uint32_t rx_head, rx_count;
+    uint16_t tx_fifo[HAL_HOST_FIFO_DEPTH]; // glyph | attr << 8
+    uint32_t tx_count;
+    uint16_t tx_last; // X of video_data: repeated when the CPU is late
+    bool video_dma;  // DMA chain serves captures, see video_dma_lookup()
+    video_dma_layout_t dma_layout;
+
+    // PIO register write engine: queued reg | value << 8 and the sys_clk cycle each
+    // write starts at. Its pin edges are replayed once the running core reaches them.
+    uint32_t crtc_ctrl_pin_base, crtc_data_pin_base;
+    uint16_t crtc_fifo[HAL_HOST_CRTC_FIFO_DEPTH + 1];
+    uint64_t crtc_start[HAL_HOST_CRTC_FIFO_DEPTH + 1];
+    uint32_t crtc_count;
+    uint32_t crtc_edge;      // Next edge of crtc_fifo[0]
+    uint64_t crtc_busy_until; // End of the last queued write
+    uint64_t crtc_burst_from[2], crtc_burst_until[2]; // D0..D7 held by the engine, [0] latest
+
+    // ISA window engine: reads are answered from the window at no CPU cost, captured
+    // writes wait with their capture time until core 1 takes them
+    bool isa_running;
+    uint32_t isa_data_pin_base, isa_oe_pin;
+    isa_vram_window_t isa_window;
+    uint32_t isa_fifo[HAL_HOST_ISA_FIFO_DEPTH];
+    uint64_t isa_captured[HAL_HOST_ISA_FIFO_DEPTH];
+    uint32_t isa_head, isa_count;
+
+    // 3DAh status engine: the timeline is played from the RA0 rising edge the harness
+    // reports through hal_host_raster_input(), in DOTCLKs of the clock generator; each
+    // run's status is stored into raster_target as the DMA would
+    uint32_t raster_ra0_pin;
+    uint8_t *raster_target;
+    const uint32_t *raster_timeline;
+    uint32_t raster_words, raster_index;
+    bool raster_armed;    // Restarted, waits for RA0 low then high
+    bool raster_ra0_low;
+    bool raster_running;
+    uint64_t raster_at;   // Virtual time the engine has been run up to
+    uint64_t raster_synced; // ... and the RA0 edge it started on
+    double raster_left;   // DOTCLKs left in the current run
+
+    void (*on_input)(void);
+    void (*on_output)(uint32_t prev, uint32_t now);
+    uint32_t (*console_read)(uint8_t *buf, uint32_t max); // Console input, bytes copied
+    void (*console_write)(const uint8_t *buf, uint32_t len);
+    void (*on_isa_write_taken)(uint32_t sample, uint64_t captured); // Core 1 took it at hal_host.cycles
+} hal_host_t;
+
+extern hal_host_t hal_host;
+
+void hal_host_reset(uint32_t sys_hz);
+// Advance virtual time without touching the pins
+void hal_host_spend(uint64_t cycles);
+// Continue on the other core's clock
+void hal_host_select_core(uint32_t core);
+// video_addr pushes a changed MA/RA sample; false if the RX FIFO was full and it was dropped
+bool hal_host_video_capture(uint32_t sample);
+// video_data output slot: the pair driven onto D0..D7, false if the CPU missed the slot
+bool hal_host_video_output(uint16_t *value);
+// isa_vram_write samples a CPU write at `at`; false if the FIFO was full and it was dropped
+bool hal_host_isa_write(uint32_t address, uint8_t value, uint64_t at);
+// The same for an OUT isa_vram_io_decode() passes: both strobes low, /VRAMOE sampled low
+bool hal_host_isa_io_write(uint16_t port, uint8_t value, uint64_t at);
+// isa_vram_read and its DMA chain answer a CPU read from the current window
+uint8_t hal_host_isa_read(uint32_t address);
+// MA/RA changed to `sample` at `at`: the status engine watches RA0
+void hal_host_raster_input(uint32_t sample, uint64_t at);
+// Run the status engine up to `at` (a read of its byte is due then)
+void hal_host_raster_run(uint64_t at);
+// D0..D7 belonged to the register write engine at `at` (a CPU cycle then collides)
+bool hal_host_crtc_bus_claimed(uint64_t at);
+static inline double hal_host_time_us(void) {
+    return (double) hal_host.cycles * 1e6 / hal_host.sys_hz;
+}
+
+void hal_system_init(uint32_t sys_hz);
+void hal_gpio_init(uint32_t pin);
+void hal_gpio_set_dir(uint32_t pin, bool out);
+void hal_gpio_set_dir_masked(uint32_t mask, uint32_t value);
+void hal_gpio_put(uint32_t pin, bool value);
+void hal_gpio_put_masked(uint32_t mask, uint32_t value);
+uint32_t hal_gpio_get_all(void);
+void hal_sleep_us(uint64_t us);
+void hal_busy_wait_ms(uint32_t ms);
+void hal_busy_wait_cycles(uint32_t cycles);
+void hal_core1_launch(void (*entry)(void));
+void hal_interrupts_disable(void);
+void hal_clock_init(uint32_t pin, float freq);
+void hal_clock_set_div(uint32_t div);
+uint32_t hal_console_read(uint8_t *buf, uint32_t max);
+void hal_console_write(const uint8_t *buf, uint32_t len);
+uint64_t hal_time_us(void);
+void hal_flash_read(uint32_t offset, void *buf, uint32_t len);
+
+void hal_video_init(uint32_t addr_pin_base, uint32_t data_pin_base);
+bool hal_video_addr_pending(void);
+uint32_t hal_video_addr_get(void);
+void hal_video_data_put(uint16_t value);
+void hal_video_dma_init(uint32_t addr_pin_base, uint32_t data_pin_base, const video_dma_layout_t *layout);
+void hal_video_dma_set_layout(const video_dma_layout_t *layout);
+void hal_crtc_write_init(uint32_t ctrl_pin_base, uint32_t data_pin_base);
+bool hal_crtc_write_ready(void);
+void hal_crtc_write(uint8_t reg, uint8_t value);
+void hal_crtc_write_poll(void);
+void hal_isa_vram_init(uint32_t addr_pin_base, uint32_t data_pin_base, uint32_t oe_pin, uint32_t wr_pin,
+                       const isa_vram_window_t *window);
+void hal_isa_vram_set_window(const isa_vram_window_t *window);
+bool hal_isa_vram_write_pending(void);
+uint32_t hal_isa_vram_write_get(void);
+void hal_raster_init(uint32_t ra0_pin, uint8_t *target);
+void hal_raster_start(const uint32_t *timeline, uint32_t words);
+void hal_raster_stop(void);
+void hal_raster_set_target(uint8_t *target);
+uint8_t hal_raster_status(void);
@@ -0,0 +1,170 @@
+#include "io_ports.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cga_io.h"
+#include "hal.h"
+#include "isa_vram.h"
+#include "upload_protocol.h"
+#include "video_modes.h"
+
+typedef struct {
+    uint32_t ms;         // Virtual time the OUTs go out
+    uint8_t writes[16];  // (port & 0xFF, value) pairs; at most 8, the ISA capture FIFO
+    uint8_t count;
+    uint8_t r1, r13;     // What the CRTC holds by the next step
+    double dotclk_mhz;
+    bool rejected;       // Console only: the packet is too big to go out whole and
+                         // nothing changes; the ISA bus has no such limit
+} io_step_t;
+
+static const io_step_t steps[] = {
+    {100, {0xD8, CGA_MODE_VALUE_40x25}, 1, 40, 0, 7.15909, false},
+    {200, {0xD8, CGA_MODE_VALUE_320x200, 0xD9, 0x30}, 2, 40, 0, 7.15909, false},
+    // BIOS mode 6: 80 bytes a line at the full DOTCLK
+    {300, {0xD8, CGA_MODE_VALUE_640x200}, 1, 80, 0, 14.31818, false},
+    {400, {0xD8, CGA_MODE_VALUE_80x25}, 1, 80, 0, 14.31818, false},
+    // A mode change and a CRTC write in one packet do not fit the mailbox budget
+    {500, {0xD8, CGA_MODE_VALUE_40x25, 0xD4, 13, 0xD5, 80}, 3, 40, 80, 7.15909, true},
+    // A mode change loads the whole table, R12/R13 included
+    {600, {0xD8, CGA_MODE_VALUE_80x25}, 1, 80, 0, 14.31818, false},
+    {700, {0xD4, 13, 0xD5, 80}, 2, 80, 80, 14.31818, false},
+    // 160x100 as a program sets it up from 80x25: R4..R7 for 100 rows, then R9 = 1 moves
+    // the fetch engine to the tweak cells
+    {800, {0xD4, 4, 0xD5, 0x7F, 0xD4, 6, 0xD5, 0x64, 0xD4, 7, 0xD5, 0x70, 0xD4, 9, 0xD5, 1}, 8, 80, 80, 14.31818, false},
+};
+#define STEPS (sizeof(steps) / sizeof(steps[0]))
+#define STEP_GAP_MS 100
+
+static struct {
+    uint32_t step;
+    uint32_t failed;
+    uint32_t lost; // Register cycles the FIFO did not take
+    uint8_t seq;
+    uint8_t tx[UPLOAD_MAX_PACKET];
+    uint32_t tx_len, tx_pos;
+    uint32_t acks, rejects, naks;
+    uint8_t reply[UPLOAD_REPLY_SIZE];
+    uint32_t reply_len;
+
+    uint64_t samples, exact, near_edge, settling, wrong;
+    uint64_t retrace, display_off, model_retrace, model_display_off;
+} io;
+
+void io_ports_init(void) {
+    memset(&io, 0, sizeof(io));
+}
+
+double io_ports_run_us(void) {
+    return (steps[STEPS - 1].ms + STEP_GAP_MS) * 1000.0;
+}
+
+// What the clock SM makes of a nominal DOTCLK: the 16.8 divider truncates, as in DOTCLK()
+static double divided_mhz(const double mhz) {
+    const uint32_t div = (uint32_t) (hal_host.sys_hz * 128.0 / (mhz * 1e6));
+    return hal_host.sys_hz * 128.0 / div / 1e6;
+}
+
+static bool check_step(const io_step_t *step, const mc6845_model_t *crtc) {
+    const double mhz = hal_host.clock_freq / 1e6;
+    const io_step_t *expected = step->rejected && !CGA_ISA_VRAM ? step - 1 : step;
+    const double expected_mhz = divided_mhz(expected->dotclk_mhz);
+    const bool ok = crtc->regs[1] == expected->r1 && crtc->regs[13] == expected->r13 &&
+                    mhz > expected_mhz - 0.001 && mhz < expected_mhz + 0.001;
+    printf("  %4u ms:", step->ms);
+    for (uint32_t i = 0; i < step->count; i++) {
+        printf(" %03Xh<-%02Xh", 0x300 | step->writes[2 * i], step->writes[2 * i + 1]);
+    }
+    printf("%s -> CRTC R1=%u R13=%u, DOTCLK %.5f MHz: %s\n", step->rejected && !CGA_ISA_VRAM ? " (rejected)" : "",
+           crtc->regs[1], crtc->regs[13], mhz, ok ? "ok" : "WRONG");
+    return ok;
+}
+
+static void issue_step(const io_step_t *step) {
+#if CGA_ISA_VRAM
+    // One register cycle per microsecond, captured as the PIO would
+    const uint64_t us = hal_host.sys_hz / 1000000;
+    for (uint32_t i = 0; i < step->count; i++) {
+        const uint16_t port = 0x300 | step->writes[2 * i];
+        if (!isa_vram_io_decode(port) ||
+            !hal_host_isa_io_write(port, step->writes[2 * i + 1],
+                                   hal_host.cycles + i * us + ISA_VRAM_WRITE_SAMPLE_CYCLES)) {
+            io.lost++;
+        }
+    }
+#else
+    io.tx_len = (uint32_t) upload_encode(io.tx, UPLOAD_PORT, io.seq++, 0, step->writes, step->count * 2);
+    io.tx_pos = 0;
+#endif
+}
+
+void io_ports_poll(const mc6845_model_t *crtc) {
+    if (io.step == STEPS || hal_host_time_us() < steps[io.step].ms * 1000.0) {
+        return;
+    }
+    if (io.step && !check_step(&steps[io.step - 1], crtc)) {
+        io.failed++;
+    }
+    issue_step(&steps[io.step++]);
+}
+
+void io_ports_sample(const uint8_t status, const bool de, const bool vsync, const bool near_edge,
+                     const bool settling) {
+    const uint8_t expected = CGA_STATUS_IDLE | (de ? 0 : CGA_STATUS_DISPLAY_OFF) | (vsync ? CGA_STATUS_VRETRACE : 0);
+    io.samples++;
+    io.retrace += !!(status & CGA_STATUS_VRETRACE);
+    io.display_off += !!(status & CGA_STATUS_DISPLAY_OFF);
+    io.model_retrace += vsync;
+    io.model_display_off += !de;
+    if (status == expected) io.exact++;
+    else if (near_edge) io.near_edge++;
+    else if (settling) io.settling++;
+    else io.wrong++;
+}
+
+bool io_ports_report(const mc6845_model_t *crtc, const uint64_t fetch_lost) {
+    if (io.step && !check_step(&steps[io.step - 1], crtc)) {
+        io.failed++;
+    }
+#if !CGA_ISA_VRAM
+    uint32_t expected_rejects = 0;
+    for (uint32_t i = 0; i < STEPS; i++) {
+        expected_rejects += steps[i].rejected;
+    }
+    printf("  UPLOAD_PORT packets ACK %u, REJECT %u (%u expected), NAK %u\n", io.acks, io.rejects, expected_rejects,
+           io.naks);
+    if (io.rejects != expected_rejects || io.naks || io.acks + io.rejects != STEPS) io.failed++;
+#else
+    printf("  register cycles on the ISA bus, %u not captured\n", io.lost);
+    if (io.lost) io.failed++;
+#endif
+    const double n = io.samples ? (double) io.samples : 1.0;
+    printf("  3DAh samples %llu: exact %llu, within %.0f us of a DE/VSYNC edge %llu, in a frame being retimed %llu, "
+           "wrong %llu\n",
+           (unsigned long long) io.samples, (unsigned long long) io.exact, IO_PORTS_EDGE_US,
+           (unsigned long long) io.near_edge, (unsigned long long) io.settling, (unsigned long long) io.wrong);
+    printf("  retrace %.1f%% (model %.1f%%), display off %.1f%% (model %.1f%%)\n", 100.0 * io.retrace / n,
+           100.0 * io.model_retrace / n, 100.0 * io.display_off / n, 100.0 * io.model_display_off / n);
+    return !io.failed && !io.wrong && io.samples && !fetch_lost;
+}
+
+uint32_t io_ports_read(uint8_t *buf, const uint32_t max) {
+    const uint32_t n = io.tx_len - io.tx_pos < max ? io.tx_len - io.tx_pos : max;
+    memcpy(buf, io.tx + io.tx_pos, n);
+    io.tx_pos += n;
+    return n;
+}
+
+// Replies among console text: look for the magic, then status and sequence number
+void io_ports_write(const uint8_t *buf, const uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        if (!io.reply_len && buf[i] != UPLOAD_MAGIC0) continue;
+        io.reply[io.reply_len++] = buf[i];
+        if (io.reply_len < UPLOAD_REPLY_SIZE) continue;
+        io.reply_len = 0;
+        io.acks += io.reply[1] == UPLOAD_ACK;
+        io.rejects += io.reply[1] == UPLOAD_REJECT;
+        io.naks += io.reply[1] == UPLOAD_NAK;
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// 3Dxh register traffic for cga_sim io (cga_io.h): OUTs to 3D8h/3D9h/3D4h/3D5h as a
+// program would make them, over the console as UPLOAD_PORT packets or, in
+// CGA_ISA_VRAM builds, as register cycles on the ISA bus. Each step is checked
+// against the CRTC model and the DOTCLK a little later: 3D8h must switch the fetch
+// mode, the clock and the timings on its own, without the 't'/'g'/'h' keys.
+// cga_sim samples 3DAh through cga_io_read() meanwhile and hands each sample here with
+// the model's DE and VSYNC; a sample that disagrees is only an error if no DE or VSYNC
+// edge is near it (the firmware's clock is the 1 us timer) and the CRTC is not in the
+// frame its timings were rewritten in (the firmware anchors on the next one).
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mc6845_model.h"
+
+// A sample that far from a DE or VSYNC edge has to be exact
+#define IO_PORTS_EDGE_US 2.0
+
+void io_ports_init(void);
+// Issue the OUTs that are due at hal_host.cycles and check the last step
+void io_ports_poll(const mc6845_model_t *crtc);
+void io_ports_sample(uint8_t status, bool de, bool vsync, bool near_edge, bool settling);
+// Virtual time the steps need, in us
+double io_ports_run_us(void);
+// false on a wrong step or 3DAh sample, or if any displayed byte was dropped or late
+bool io_ports_report(const mc6845_model_t *crtc, uint64_t fetch_lost);
+
+// Console side, for hal_host.console_read/console_write
+uint32_t io_ports_read(uint8_t *buf, uint32_t max);
+void io_ports_write(const uint8_t *buf, uint32_t len);
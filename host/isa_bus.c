@@ -0,0 +1,300 @@
+#include "isa_bus.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hal.h"
+#include "isa_vram.h"
+#include "video_memory.h"
+
+#define WINDOW_MAX (1 << ISA_VRAM_GRAPHICS_BITS)
+#define ISA_BASE 0xB8000u
+
+typedef struct {
+    const char *name;
+    double clock_hz;
+    uint32_t cycle_clocks;  // One memory cycle to the next, back to back
+    uint32_t strobe_clocks; // /MEMR or /MEMW low; read data is latched as /MEMR rises
+} isa_profile_t;
+
+// No IOCHRDY from this board: an 8088 cycle is T1-T4 with the command in T2-T3, the AT
+// runs 8-bit memory cycles with 4 wait states (6 clocks, command for 4 of them)
+static const isa_profile_t profiles[] = {
+    {"XT 4.77 MHz", 4772727.0, 4, 2},
+    {"AT 8.33 MHz 8-bit", 8333333.0, 6, 4},
+};
+#define PROFILES (sizeof(profiles) / sizeof(profiles[0]))
+
+enum { WORK_FILL, WORK_ECHO, WORK_RANDOM, WORKLOADS };
+static const char *const workload_names[WORKLOADS] = {"fill", "write+read back", "random"};
+
+typedef struct {
+    uint64_t reads, writes, ignored, collided, dropped, hazards, wrong;
+    uint64_t latency_max, latency_sum; // Write strobe to the byte stored, sys_clk cycles
+    int64_t margin_min;                // Read-back: RAM read minus store of the byte
+    uint32_t fifo_max;
+} isa_stats_t;
+
+static struct {
+    uint32_t frames;
+    uint64_t next;      // Strobe of the next cycle
+    uint32_t phase;     // profile * WORKLOADS + workload
+    uint64_t phase_end;
+    uint32_t seq, rng;
+    int32_t read_back;  // Offset the echo workload reads next, -1 for a write
+    uint32_t mask;      // Window the firmware has set
+    uint8_t expected[WINDOW_MAX];
+    bool known[WINDOW_MAX];
+    uint64_t captured_at[WINDOW_MAX]; // Capture of the last write to the offset
+    uint64_t stored_at[WINDOW_MAX];   // When that write reached RAM, UINT64_MAX until then
+    uint8_t write_phase[WINDOW_MAX];
+    isa_stats_t stats[PROFILES * WORKLOADS];
+} bus;
+
+static uint32_t random_next(void) {
+    bus.rng = bus.rng * 1103515245u + 12345u;
+    return bus.rng >> 8;
+}
+
+static uint64_t bus_cycles(const isa_profile_t *p, const uint32_t clocks) {
+    return (uint64_t) (clocks * (double) hal_host.sys_hz / p->clock_hz + 0.5);
+}
+
+static double cycles_ns(const uint64_t cycles) {
+    return cycles * 1e9 / hal_host.sys_hz;
+}
+
+// ---------------- isa-vram.pld against the RP2040 buffers ----------------
+
+bool isa_bus_decode_check(void) {
+    uint32_t decoded = 0, wrong_decode = 0, wrong_map = 0;
+    for (int gsel = 0; gsel < 2; gsel++) {
+        for (uint32_t address = 0xB0000; address < 0xC8000; address++) {
+            for (int strobe = 0; strobe < 4; strobe++) {
+                const bool memr = strobe & 1, memw = strobe >> 1;
+                const isa_vram_decode_t d = isa_vram_decode(address, memr, memw, gsel);
+                const bool window = address >= 0xB8000 && address < 0xC0000;
+                wrong_decode += d.cpu_access != window || d.oe != (window && memr) || d.wr != (window && memw) ||
+                                (window && d.bank0 == d.bank1) || (!window && (d.bank0 || d.bank1));
+                if (!window || strobe) continue;
+                decoded++;
+
+                // 6164 byte: bank, A1..A12 and VRAMA0 -> window offset the RP2040 uses
+                const uint32_t sram = (address & 0x1FFE) | d.vram_a0;
+                if (gsel) {
+                    wrong_map += ((d.bank1 ? 1u << 13 : 0) | sram) != (address & (GRAPHICS_WINDOW_BYTES - 1));
+                } else {
+                    // Char and attribute banks interleave; 4 KB of cells alias the upper 4 KB
+                    wrong_map += ((sram | d.bank1) & (TEXT_WINDOW_BYTES - 1)) != (address & (TEXT_WINDOW_BYTES - 1));
+                }
+            }
+        }
+    }
+
+    // A byte stored as core 1 does comes back through the read chain's pointer arithmetic,
+    // and a text cell reaches the row planes, an attribute the tweak cells; a store to
+    // the status byte changes nothing
+    uint32_t wrong_store = 0;
+    video_memory_init();
+    const video_font_t *font = &video_page_font[0];
+    for (int kind = VIDEO_WINDOW_TEXT; kind <= VIDEO_WINDOW_GRAPHICS; kind++) {
+        const isa_vram_window_t window = isa_vram_window(kind, 0);
+        for (uint32_t offset = 0; offset < 1u << window.index_bits; offset += 7) {
+            const uint8_t value = (uint8_t) (offset * 13 + kind);
+            isa_vram_store(kind, 0, offset, value);
+            wrong_store += isa_vram_lookup(&window, ISA_BASE + offset) != value;
+            if (kind == VIDEO_WINDOW_GRAPHICS) {
+                wrong_store += (offset & 1) && tweak_cells[0][offset >> 1] !=
+                                                   (font->glyphs[TWEAK_GLYPH * font->rows] | value << 8);
+            } else {
+                const uint32_t cell = offset >> 1;
+                const uint8_t ch = text_buffer[0][2 * cell], attr = text_buffer[0][2 * cell + 1];
+                const uint8_t glyph_row = font->glyphs[ch * font->rows + (offset & 7)];
+                wrong_store += text_rows[0][offset & 7][cell] != (glyph_row | attr << 8);
+            }
+        }
+        const uint32_t status = ISA_VRAM_STATUS_ADDRESS & ((1u << window.index_bits) - 1);
+        const uint8_t held = isa_vram_lookup(&window, ISA_BASE + status);
+        isa_vram_store(kind, 0, status, (uint8_t) ~held);
+        wrong_store += isa_vram_lookup(&window, ISA_BASE + status) != held;
+    }
+    video_memory_init();
+
+    printf("isa-vram.pld model: B0000-C7FFF x GSEL x /MEMR,/MEMW, %u window addresses per mode\n", decoded / 2);
+    printf("  decode errors %u, 6164 byte vs RP2040 window offset %u, store/read-back errors %u\n", wrong_decode,
+           wrong_map, wrong_store);
+    return !wrong_decode && !wrong_map && !wrong_store;
+}
+
+// ---------------- Bus master ----------------
+
+static void on_write_taken(const uint32_t sample, const uint64_t captured) {
+    const uint32_t offset = sample & bus.mask;
+    const uint64_t store = bus.mask == (1u << ISA_VRAM_GRAPHICS_BITS) - 1 ? ISA_VRAM_STORE_CYCLES_GRAPHICS
+                                                                          : ISA_VRAM_STORE_CYCLES_TEXT;
+    const uint64_t stored = hal_host.cycles + store;
+    isa_stats_t *s = &bus.stats[bus.write_phase[offset]];
+    const uint64_t latency = stored - (captured - ISA_VRAM_WRITE_SAMPLE_CYCLES);
+    s->latency_sum += latency;
+    if (latency > s->latency_max) s->latency_max = latency;
+    if (captured == bus.captured_at[offset]) bus.stored_at[offset] = stored;
+}
+
+void isa_bus_init(const uint32_t frames, const uint64_t start) {
+    memset(&bus, 0, sizeof(bus));
+    bus.frames = frames;
+    bus.next = start;
+    bus.phase_end = start + (uint64_t) frames * hal_host.sys_hz / 60;
+    bus.rng = 1;
+    bus.read_back = -1;
+    bus.mask = (1u << hal_host.isa_window.index_bits) - 1;
+    for (uint32_t offset = 0; offset <= bus.mask; offset++) {
+        bus.expected[offset] = hal_host_isa_read(ISA_BASE + offset);
+        bus.known[offset] = true;
+    }
+    for (uint32_t i = 0; i < PROFILES * WORKLOADS; i++) {
+        bus.stats[i].margin_min = INT64_MAX;
+    }
+    hal_host.on_isa_write_taken = on_write_taken;
+}
+
+bool isa_bus_done(void) {
+    return bus.phase == PROFILES * WORKLOADS;
+}
+
+static void bus_write(const uint32_t address, const uint8_t value, const uint64_t at) {
+    isa_stats_t *s = &bus.stats[bus.phase];
+    const isa_vram_decode_t d = isa_vram_decode(address, false, true, bus.mask != (1u << ISA_VRAM_TEXT_BITS) - 1);
+    if (!d.wr) {
+        s->ignored++;
+        return;
+    }
+    s->writes++;
+    const uint32_t offset = address & bus.mask;
+    const uint64_t captured = at + ISA_VRAM_WRITE_SAMPLE_CYCLES;
+    // D0..D7 driven by the register write engine as well: whatever is captured is garbage
+    const bool collided = hal_host_crtc_bus_claimed(at) || hal_host_crtc_bus_claimed(captured);
+    s->collided += collided;
+    if (!hal_host_isa_write(address, collided ? value ^ 0x5A : value, captured)) {
+        s->dropped++;
+        bus.known[offset] = false;
+        return;
+    }
+    if (hal_host.isa_count > s->fifo_max) s->fifo_max = hal_host.isa_count;
+    bus.expected[offset] = value;
+    bus.known[offset] = !collided && !isa_vram_reserved(hal_host.isa_window.index_bits, offset);
+    bus.captured_at[offset] = captured;
+    bus.stored_at[offset] = UINT64_MAX;
+    bus.write_phase[offset] = bus.phase;
+}
+
+static void bus_read(const uint32_t address, const uint64_t at) {
+    isa_stats_t *s = &bus.stats[bus.phase];
+    const isa_vram_decode_t d = isa_vram_decode(address, true, false, bus.mask != (1u << ISA_VRAM_TEXT_BITS) - 1);
+    if (!d.oe) {
+        s->ignored++;
+        return;
+    }
+    s->reads++;
+    const uint32_t offset = address & bus.mask;
+    if (hal_host_crtc_bus_claimed(at)) {
+        s->collided++;
+        return;
+    }
+    // The chain reads RAM this long after /VRAMOE falls; a store still outstanding by then
+    // means the old byte goes out
+    const uint64_t sampled = at + ISA_VRAM_READ_CYCLES;
+    if (bus.captured_at[offset]) {
+        const int64_t margin = bus.stored_at[offset] == UINT64_MAX
+                                   ? INT64_MIN
+                                   : (int64_t) sampled - (int64_t) bus.stored_at[offset];
+        if (margin < s->margin_min) s->margin_min = margin;
+        if (margin < 0) {
+            s->hazards++;
+            return;
+        }
+    }
+    if (bus.known[offset] && hal_host_isa_read(address) != bus.expected[offset]) s->wrong++;
+}
+
+// One cycle of the current workload; returns the bus clocks until the next one
+static uint32_t bus_cycle(const isa_profile_t *p, const uint32_t workload, const uint64_t at) {
+    const uint32_t size = bus.mask + 1;
+    const uint32_t seq = bus.seq++;
+    switch (workload) {
+        case WORK_FILL:
+            // REP STOSB at bus speed over the window, char/attr pairs
+            bus_write(ISA_BASE + seq % size, (seq & 1) ? 0x1F : (uint8_t) ('A' + seq / 2 % 26), at);
+            return p->cycle_clocks;
+        case WORK_ECHO:
+            // Store a byte and read it straight back on the next cycle
+            if (bus.read_back < 0) {
+                bus.read_back = (int32_t) (random_next() % size);
+                bus_write(ISA_BASE + bus.read_back, (uint8_t) random_next(), at);
+            } else {
+                bus_read(ISA_BASE + bus.read_back, at);
+                bus.read_back = -1;
+            }
+            return p->cycle_clocks;
+        default: {
+            // Reads and writes all over B0000-C7FFF, an eighth of them outside the window
+            const uint32_t r = random_next();
+            const uint32_t address = (r & 7) ? ISA_BASE + (r >> 3) % 0x8000 : 0xB0000 + (r >> 3) % 0x8000 * 3;
+            if (r >> 20 & 3) bus_read(address, at);
+            else bus_write(address, (uint8_t) (r >> 12), at);
+            return p->cycle_clocks * (1 + (r >> 22) % 8);
+        }
+    }
+}
+
+void isa_bus_run_until(const uint64_t now) {
+    while (!isa_bus_done() && bus.next <= now) {
+        if (bus.next >= bus.phase_end) {
+            bus.phase++;
+            bus.seq = 0;
+            bus.read_back = -1;
+            bus.phase_end += (uint64_t) bus.frames * hal_host.sys_hz / 60;
+            continue;
+        }
+        const isa_profile_t *p = &profiles[bus.phase / WORKLOADS];
+        bus.next += bus_cycles(p, bus_cycle(p, bus.phase % WORKLOADS, bus.next));
+    }
+}
+
+bool isa_bus_report(void) {
+    const double read_ns = cycles_ns(ISA_VRAM_READ_CYCLES + ISA_VRAM_READ_STALL_CYCLES) + ISA_VRAM_READ_EXTERNAL_NS;
+    bool ok = true;
+    printf("  ISA window %s, %u frame(s) per workload\n", bus.mask == TEXT_WINDOW_BYTES - 1 ? "text" : "graphics",
+           bus.frames);
+    for (uint32_t p = 0; p < PROFILES; p++) {
+        const isa_profile_t *profile = &profiles[p];
+        const double cycle_ns = cycles_ns(bus_cycles(profile, profile->cycle_clocks));
+        const double strobe_ns = cycles_ns(bus_cycles(profile, profile->strobe_clocks));
+        uint64_t latency_max = 0;
+        printf("  %s: cycle %.0f ns, read data due %.0f ns after /MEMR falls\n", profile->name, cycle_ns, strobe_ns);
+        for (uint32_t w = 0; w < WORKLOADS; w++) {
+            const isa_stats_t *s = &bus.stats[p * WORKLOADS + w];
+            printf("    %-16s reads %llu, writes %llu, not decoded %llu; write->RAM avg/max %.0f/%.0f ns, "
+                   "FIFO max %u, dropped %llu\n",
+                   workload_names[w], (unsigned long long) s->reads, (unsigned long long) s->writes,
+                   (unsigned long long) s->ignored, s->writes ? cycles_ns(s->latency_sum) / s->writes : 0.0,
+                   cycles_ns(s->latency_max), s->fifo_max, (unsigned long long) s->dropped);
+            char margin[32] = "no read-back";
+            if (s->margin_min == INT64_MIN) snprintf(margin, sizeof(margin), "read before stored");
+            else if (s->margin_min != INT64_MAX) snprintf(margin, sizeof(margin), "margin min %.0f ns",
+                                                          s->margin_min * 1e9 / hal_host.sys_hz);
+            printf("    %-16s stale reads %llu (%s), wrong reads %llu, cycles during CRTC bursts %llu\n", "",
+                   (unsigned long long) s->hazards, margin, (unsigned long long) s->wrong,
+                   (unsigned long long) s->collided);
+            if (s->latency_max > latency_max) latency_max = s->latency_max;
+            ok &= !s->wrong && !s->dropped && !s->hazards;
+        }
+        const bool read_ok = read_ns < strobe_ns, write_ok = cycles_ns(latency_max) < cycle_ns;
+        printf("    worst case: read %.0f ns of %.0f ns (%s), write->RAM %.0f ns of %.0f ns to the next cycle (%s)\n",
+               read_ns, strobe_ns, read_ok ? "no wait states needed" : "TOO SLOW", cycles_ns(latency_max), cycle_ns,
+               write_ok ? "read-after-write safe" : "a read-back may see the old byte");
+        ok &= read_ok && write_ok;
+    }
+    hal_host.on_isa_write_taken = NULL;
+    return ok;
+}
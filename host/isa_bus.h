@@ -0,0 +1,33 @@
+#pragma once
+
+// ISA bus master for cga_sim, the CPU side of the B8000h window (isa_vram.h).
+//
+// isa_bus_decode_check() holds the window mapping against isa-vram.pld: every address
+// around B8000h is decoded with isa_vram_decode() and the byte the two 6164s would have
+// used is compared with the one the RP2040 buffers hold for it.
+//
+// isa_bus_run_until() issues memory cycles against main.c on the simulated board
+// (CGA_ISA_VRAM builds): an 8088 at 4.77 MHz and an AT at 8.33 MHz with the default 8-bit
+// wait states, each with a back-to-back fill, write-then-read-back and a random mix,
+// some of it outside the window. Only cycles the PLD equations decode reach the board.
+// A write is captured into the simulated FIFO and is in RAM once core 1 has taken
+// and stored it; a read is answered by the read chain. Every read is checked against
+// the bytes written so far. The report gives the worst-case response times against the
+// bus timing: read data against the /MEMR deadline, write to RAM against the next bus
+// cycle (a read of the same byte would see the old value), FIFO occupancy and drops,
+// and the cycles that met a CRTC write burst holding D0..D7.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// false if the mapping and the PLD disagree anywhere
+bool isa_bus_decode_check(void);
+
+// `frames` 60 Hz frames of each workload, starting at virtual time `start`
+void isa_bus_init(uint32_t frames, uint64_t start);
+// Issue every cycle due by `now` (the virtual time both cores have reached)
+void isa_bus_run_until(uint64_t now);
+bool isa_bus_done(void);
+
+// Print the statistics; false on a wrong read, a dropped write or a response too slow
+bool isa_bus_report(void);
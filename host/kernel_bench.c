@@ -0,0 +1,121 @@
+#include "kernel_bench.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#include "board.h"
+#include "hal.h"
+#include "mc6845_model.h"
+#include "video_memory.h"
+#include "video_registry.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLE_UNIT "cycles"
+static inline uint64_t now_cycles(void) {
+    return __rdtsc();
+}
+#else
+#define CYCLE_UNIT "ns"
+static inline uint64_t now_cycles(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+#define MAX_SAMPLES (1 << 16)
+
+static uint32_t samples[MAX_SAMPLES];
+
+// The non-specialised lookups, called through pointers as the kernel is, so none of
+// them can be folded into the timing loop
+static uint16_t __attribute__((noinline)) layout_fetch(const video_dma_layout_t *layout, const uint32_t sample) {
+    return video_dma_lookup(layout, sample);
+}
+
+static uint16_t __attribute__((noinline)) dispatch_fetch(const video_mode_t mode, const uint8_t page,
+                                                        const uint32_t sample) {
+    const uint16_t address = sample & 0x3FFF;
+    const uint8_t row = sample >> 14;
+    if (mode == VIDEO_MODE_TEXT_80x25 || mode == VIDEO_MODE_TEXT_40x25) {
+        return text_rows[page][row & ((1 << TEXT_ROW_BITS) - 1)][address & ((1 << TEXT_INDEX_BITS) - 1)];
+    }
+    if (mode == VIDEO_MODE_TEXT_160x100) {
+        return tweak_cells[page][address & ((1 << GRAPHICS_INDEX_BITS) - 1)];
+    }
+    return graphics_buffer[page][row & ((1 << GRAPHICS_BANK_BITS) - 1)][address & ((1 << GRAPHICS_INDEX_BITS) - 1)] *
+           0x0101;
+}
+
+static uint16_t (*volatile layout_lookup)(const video_dma_layout_t *, uint32_t) = layout_fetch;
+static uint16_t (*volatile dispatch_lookup)(video_mode_t, uint8_t, uint32_t) = dispatch_fetch;
+
+// Changed MA/RA samples of one frame, as the capture FIFO delivers them
+static uint32_t frame_samples(const video_mode_desc_t *desc) {
+    mc6845_model_t crtc;
+    mc6845_model_init(&crtc, desc->crtc);
+    const uint32_t frame_clocks = mc6845_model_frame_clocks(desc->crtc);
+    uint32_t count = 0, prev = 0xFFFFFFFF;
+    for (uint32_t clk = 0; clk < frame_clocks && count < MAX_SAMPLES; clk++) {
+        mc6845_outputs_t pins;
+        mc6845_model_clock(&crtc, &pins);
+        const uint32_t sample = pins.ma | (uint32_t) (pins.ra & 7) << 14;
+        if (sample == prev) continue;
+        prev = sample;
+        samples[count++] = sample;
+    }
+    return count;
+}
+
+static bool bench_mode(const video_mode_t mode, const uint32_t rounds) {
+    const video_mode_desc_t *desc = video_mode_desc(mode);
+    const video_fetch_kernel_t kernel = desc->fetch;
+    const video_dma_layout_t layout = video_mode_layout(desc, 0);
+    const uint32_t count = frame_samples(desc);
+    uint64_t best[3] = {UINT64_MAX, UINT64_MAX, UINT64_MAX};
+    uint32_t sum[3] = {0, 0, 0};
+
+    for (uint32_t round = 0; round < rounds; round++) {
+        uint32_t acc[3] = {0, 0, 0};
+        uint64_t t0 = now_cycles();
+        for (uint32_t i = 0; i < count; i++) {
+            acc[0] = acc[0] * 31 + kernel(layout.table, samples[i]);
+        }
+        uint64_t t1 = now_cycles();
+        if (t1 - t0 < best[0]) best[0] = t1 - t0;
+
+        t0 = now_cycles();
+        for (uint32_t i = 0; i < count; i++) {
+            acc[1] = acc[1] * 31 + layout_lookup(&layout, samples[i]);
+        }
+        t1 = now_cycles();
+        if (t1 - t0 < best[1]) best[1] = t1 - t0;
+
+        t0 = now_cycles();
+        for (uint32_t i = 0; i < count; i++) {
+            acc[2] = acc[2] * 31 + dispatch_lookup(mode, 0, samples[i]);
+        }
+        t1 = now_cycles();
+        if (t1 - t0 < best[2]) best[2] = t1 - t0;
+
+        for (int k = 0; k < 3; k++) sum[k] = acc[k];
+    }
+
+    const bool ok = sum[0] == sum[1] && sum[0] == sum[2];
+    printf("  %-17s %5u fetches, %s/fetch: kernel %5.2f  layout %5.2f  dispatch %5.2f; "
+           "budget %.0f RP2040 cycles: %s\n",
+           desc->name, count, CYCLE_UNIT, (double) best[0] / count, (double) best[1] / count,
+           (double) best[2] / count, 8.0 * SYSTEM_CLOCK_HZ / desc->dotclk_hz, ok ? "ok" : "WRONG");
+    return ok;
+}
+
+bool kernel_bench(const uint32_t rounds) {
+    video_memory_init();
+    printf("Fetch kernels, one frame of MA/RA per mode, best of %u passes\n", rounds);
+    bool ok = true;
+    for (int mode = 0; mode < VIDEO_MODE_COUNT; mode++) {
+        ok &= bench_mode(mode, rounds);
+    }
+    return ok;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+// Fetch kernel benchmark for cga_sim: the MA/RA samples of one frame of every mode,
+// from the CRTC model, through three lookups of the same data, timed in host cycles:
+//   kernel    the mode's kernel through its descriptor pointer, as the fetch loop calls it
+//   layout    one kernel for every mode, video_dma_lookup() with the layout at run time
+//   dispatch  a mode test on every sample before the lookup, what the per-mode kernels
+//             replaced
+// The best of `rounds` passes counts. Host cycles are no RP2040 cycles, the ratios
+// between the columns are what to look at; the line also gives the budget per fetch in
+// RP2040 cycles at SYSTEM_CLOCK_HZ. Sizes of the kernels in the binary:
+// cmake --build ... --target <target>_kernels (CMakeLists.txt).
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// false if the three lookups disagree for any sample
+bool kernel_bench(uint32_t rounds);
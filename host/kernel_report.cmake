@@ -0,0 +1,35 @@
+# Size and disassembly of the fetch kernels (video_fetch_*) in a linked binary, for
+# comparing layouts and compiler flags; run through the <target>_kernels targets:
+#   cmake -DNM=... -DOBJDUMP=... -DELF=... -DOUT=... -P host/kernel_report.cmake
+# Sizes go to the console, sizes and disassembly to OUT.
+execute_process(COMMAND ${NM} --print-size --size-sort --radix=d ${ELF}
+        OUTPUT_VARIABLE symbols RESULT_VARIABLE failed)
+if (failed)
+    message(FATAL_ERROR "${NM} failed on ${ELF}")
+endif ()
+string(REPLACE "\n" ";" symbols "${symbols}")
+set(report "")
+foreach (line IN LISTS symbols)
+    if (NOT line MATCHES "^[0-9]+ ([0-9]+) [tT] (video_fetch_[a-z0-9_]+)$")
+        continue()
+    endif ()
+    set(size ${CMAKE_MATCH_1})
+    set(name ${CMAKE_MATCH_2})
+    math(EXPR size "${size}")
+    message(STATUS "${name}: ${size} bytes")
+    execute_process(COMMAND ${OBJDUMP} -d --no-show-raw-insn --disassemble=${name} ${ELF}
+            OUTPUT_VARIABLE listing)
+    # Only the function's own block, not the section headers around it
+    string(FIND "${listing}" "<${name}>:" start)
+    if (start EQUAL -1)
+        set(start 0)
+    endif ()
+    string(SUBSTRING "${listing}" ${start} -1 listing)
+    string(FIND "${listing}" "\n\n" end)
+    string(SUBSTRING "${listing}" 0 ${end} listing)
+    string(APPEND report "${name}: ${size} bytes\n${listing}\n")
+endforeach ()
+if (report STREQUAL "")
+    message(FATAL_ERROR "no video_fetch_* functions in ${ELF}")
+endif ()
+file(WRITE ${OUT} "${report}")
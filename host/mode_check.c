@@ -0,0 +1,95 @@
+#include "mode_check.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cga_io.h"
+#include "mc6845_model.h"
+#include "video_memory.h"
+#include "video_registry.h"
+
+// NTSC CGA monitor: 15.7 kHz lines, 60 Hz frames
+#define LINE_HZ_MIN  15600.0
+#define LINE_HZ_MAX  15850.0
+#define FRAME_HZ_MIN 59.5
+#define FRAME_HZ_MAX 60.5
+
+static uint8_t seen[1 << 16]; // One flag per table entry
+
+// The mode the descriptor's 3D8h value selects, and its R9 after that
+static bool selects(const video_mode_t mode, const video_mode_desc_t *desc) {
+    video_mode_t selected = cga_io_video_mode(desc->mode_control), tweaked;
+    if (cga_io_tweak_mode(selected, desc->crtc[9], &tweaked)) {
+        selected = tweaked;
+    }
+    return selected == mode;
+}
+
+static bool check_mode(const video_mode_t mode) {
+    const video_mode_desc_t *desc = video_mode_desc(mode);
+    const uint8_t *r = desc->crtc;
+    const double char_hz = desc->dotclk_hz / 8.0; // character.pld divider
+    const uint32_t frame_clocks = mc6845_model_frame_clocks(r);
+    const double line_hz = char_hz / (r[0] + 1);
+    const double frame_hz = char_hz / frame_clocks;
+
+    const uint32_t index_bits = desc->ma_bits + desc->row_bits;
+    const uint32_t align = 1u << (index_bits + desc->entry_shift);
+    const bool aligned = !((uintptr_t) desc->table & (align - 1)) && !(desc->page_bytes & (align - 1)) &&
+                         desc->page_bytes >= align && index_bits <= 16;
+
+    const uint32_t row_lines = (r[9] & 0x1F) + 1u;
+    const uint32_t shown_rows = row_lines < 1u << desc->row_bits ? row_lines : 1u << desc->row_bits;
+    const uint32_t expected_entries = (uint32_t) r[1] * (r[6] & 0x7F) * shown_rows;
+
+    mc6845_model_t crtc;
+    mc6845_model_init(&crtc, r);
+    memset(seen, 0, sizeof(seen));
+    uint32_t de_clocks = 0, vsyncs = 0, entries = 0, wrapped = 0, mismatches = 0;
+    bool vsync = false;
+    for (uint32_t clk = 0; clk < frame_clocks; clk++) {
+        mc6845_outputs_t pins;
+        mc6845_model_clock(&crtc, &pins);
+        vsyncs += pins.vsync && !vsync;
+        vsync = pins.vsync;
+        if (!pins.de) continue;
+        de_clocks++;
+        wrapped += pins.ma >> desc->ma_bits != 0;
+        const uint32_t row = pins.ra & ((1u << desc->row_bits) - 1);
+        const uint32_t index = (row << desc->ma_bits | (pins.ma & ((1u << desc->ma_bits) - 1))) & 0xFFFF;
+        entries += !seen[index];
+        seen[index] = 1;
+        // Same sample as the firmware: MA on GPIO0..13, RA2..RA0 on GPIO14..16
+        const uint32_t sample = pins.ma | (uint32_t) (pins.ra & 7) << 14;
+        for (uint8_t page = 0; page < VIDEO_PAGES; page++) {
+            const video_dma_layout_t layout = video_mode_layout(desc, page);
+            mismatches += video_dma_lookup(&layout, sample) != desc->fetch(layout.table, sample);
+        }
+    }
+
+    const bool timing = line_hz >= LINE_HZ_MIN && line_hz <= LINE_HZ_MAX && frame_hz >= FRAME_HZ_MIN &&
+                        frame_hz <= FRAME_HZ_MAX && vsyncs == 1 && de_clocks == (uint32_t) r[1] * (r[6] & 0x7F) * row_lines;
+    const bool geometry = aligned && !wrapped && entries == expected_entries;
+    const bool ok = timing && geometry && !mismatches && selects(mode, desc);
+    printf("  %-17s %5.2f kHz %5.2f Hz, DE %5u clocks, %5u of %5u entries%s, kernel/DMA mismatches %u, "
+           "3D8h %02Xh: %s\n",
+           desc->name, line_hz / 1000, frame_hz, de_clocks, entries, 1u << index_bits, wrapped ? " (MA wraps)" : "",
+           mismatches, desc->mode_control, ok ? "ok" : "WRONG");
+    if (!timing) printf("    timing: %u VSYNC pulse(s), R1 x R6 x (R9 + 1) = %u\n", vsyncs,
+                        (uint32_t) r[1] * (r[6] & 0x7F) * row_lines);
+    if (!geometry) printf("    geometry: %u distinct entries expected, table %s\n", expected_entries,
+                          aligned ? "aligned" : "NOT aligned to its index");
+    if (!selects(mode, desc)) printf("    3D8h %02Xh with R9 = %u does not select the mode\n", desc->mode_control, r[9]);
+    return ok;
+}
+
+bool mode_check(void) {
+    video_memory_init();
+    printf("Mode descriptors against the MC6845 model, %u mode(s)\n", (unsigned) VIDEO_MODE_COUNT);
+    bool ok = true;
+    for (int mode = 0; mode < VIDEO_MODE_COUNT; mode++) {
+        ok &= check_mode(mode);
+    }
+    return ok;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Mode descriptors (video_registry.h) against the CRTC model, for cga_sim modes.
+//
+// Each entry's R0-R15 are run through the model for a frame at the entry's DOTCLK:
+// line and frame rate must be what a CGA monitor syncs to, the frame must have one
+// VSYNC and R1 x R6 x (R9 + 1) DE clocks. Every displayed MA/RA must land inside the
+// entry's buffer geometry without wrapping, on an entry of its own (rows past row_bits
+// may repeat, as in 160x100), and the kernel must return what the DMA chain reads
+// there on both pages. The entry's 3D8h value has to select the mode through
+// cga_io_video_mode() (and R9, cga_io_tweak_mode()), as a program's OUTs would.
+
+#include <stdbool.h>
+
+// false if any descriptor disagrees with the model
+bool mode_check(void);
@@ -0,0 +1,161 @@
+#include "retrace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cga_io.h"
+#include "hal.h"
+
+// One pass of the loop, IN AL,DX / TEST AL,8 / JZ (taken), in ns: 8088 at 4.77 MHz,
+// 12 + 4 + 16 clocks with the 4-clock I/O cycle; AT at 8 MHz, 5 + 2 + 7 clocks plus
+// the 8-bit I/O cycle with its default wait states, about 1 us
+#define RETRACE_XT_LOOP_NS 6708
+#define RETRACE_AT_LOOP_NS 2750
+#define RETRACE_EDGES 64
+
+typedef struct {
+    const char *name;
+    uint64_t loop;        // sys_clk cycles per pass
+    uint64_t next;        // Next IN
+    bool in_retrace;      // Second loop: waiting for bit 3 to clear
+    uint64_t caught, exits;
+    uint64_t reads, exact, near_edge, settling, wrong;
+    uint64_t late_start, late_end; // Worst exit after the edge waited for, cycles
+    uint64_t late_exits;  // Exits more than one pass after their edge
+} retrace_cpu_t;
+
+static struct {
+    retrace_cpu_t cpu[2];
+    struct {
+        uint64_t at;
+        bool de, vsync;
+    } edges[RETRACE_EDGES];
+    uint32_t edge_count;
+    uint64_t retraces;     // VSYNC pulses of the model outside retimed frames
+    bool settling;
+    uint64_t settled;      // The board ran out of the retimed frame by then
+} rt;
+
+void retrace_init(const uint64_t start) {
+    memset(&rt, 0, sizeof(rt));
+    const uint64_t ns = hal_host.sys_hz / 1000000;
+    rt.cpu[0] = (retrace_cpu_t) {.name = "XT 4.77 MHz", .loop = RETRACE_XT_LOOP_NS * ns / 1000, .next = start};
+    rt.cpu[1] = (retrace_cpu_t) {.name = "AT 8 MHz", .loop = RETRACE_AT_LOOP_NS * ns / 1000, .next = start + 1};
+}
+
+void retrace_edge(const bool de, const bool vsync, const uint64_t at) {
+    const bool was = rt.edge_count && rt.edges[(rt.edge_count - 1) % RETRACE_EDGES].vsync;
+    if (vsync && !was && !rt.settling) rt.retraces++;
+    rt.edges[rt.edge_count % RETRACE_EDGES].at = at;
+    rt.edges[rt.edge_count % RETRACE_EDGES].de = de;
+    rt.edges[rt.edge_count % RETRACE_EDGES].vsync = vsync;
+    rt.edge_count++;
+}
+
+// Index of the last edge at or before `at`, -1 if it has left the ring
+static int edge_before(const uint64_t at) {
+    for (uint32_t i = 0; i < RETRACE_EDGES && i < rt.edge_count; i++) {
+        const uint32_t n = (rt.edge_count - 1 - i) % RETRACE_EDGES;
+        if (rt.edges[n].at <= at) return (int) n;
+    }
+    return -1;
+}
+
+// When VSYNC last went to `level` at or before edge n
+static bool vsync_edge(const int n, const bool level, uint64_t *at) {
+    for (uint32_t i = 0; i < RETRACE_EDGES && i < rt.edge_count; i++) {
+        const uint32_t k = (n + RETRACE_EDGES - i) % RETRACE_EDGES;
+        const uint32_t prev = (k + RETRACE_EDGES - 1) % RETRACE_EDGES;
+        if (i + 1 < rt.edge_count && rt.edges[k].vsync == level && rt.edges[prev].vsync != level) {
+            *at = rt.edges[k].at;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool near_edge(const uint64_t at, const uint64_t tolerance) {
+    for (uint32_t i = 0; i < RETRACE_EDGES && i < rt.edge_count; i++) {
+        const uint64_t edge = rt.edges[i].at;
+        if ((edge > at ? edge - at : at - edge) <= tolerance) return true;
+    }
+    return false;
+}
+
+// The IN itself, at virtual time `at`
+static uint8_t read_status(const uint64_t at) {
+    hal_host_raster_run(at);
+#if CGA_ISA_VRAM
+    return hal_host_isa_read(ISA_VRAM_STATUS_ADDRESS);
+#else
+    return *hal_host.raster_target;
+#endif
+}
+
+static void run_in(retrace_cpu_t *cpu, const uint64_t tolerance) {
+    const uint64_t at = cpu->next;
+    cpu->next += cpu->loop;
+    const uint8_t status = read_status(at);
+    // Until the engine has synced on new timings the byte holds whatever it last stored
+    const bool stale = at <= rt.settled || !hal_host.raster_running || at < hal_host.raster_synced;
+    const int n = edge_before(at);
+    if (n < 0) return;
+
+    cpu->reads++;
+    const uint8_t expected = CGA_STATUS_IDLE | (rt.edges[n].de ? 0 : CGA_STATUS_DISPLAY_OFF) |
+                             (rt.edges[n].vsync ? CGA_STATUS_VRETRACE : 0);
+    if (status == expected) cpu->exact++;
+    else if (near_edge(at, tolerance)) cpu->near_edge++;
+    else if (stale) cpu->settling++;
+    else cpu->wrong++;
+
+    // The loop itself: leaves on the bit, late by however far the edge was before the IN
+    const bool retrace = status & CGA_STATUS_VRETRACE;
+    if (retrace == cpu->in_retrace) return;
+    cpu->in_retrace = retrace;
+    uint64_t edge;
+    if (stale || !vsync_edge(n, retrace, &edge) || edge > at) return;
+    const uint64_t late = at - edge;
+    if (retrace) {
+        cpu->caught++;
+        if (late > cpu->late_start) cpu->late_start = late;
+    } else {
+        cpu->exits++;
+        if (late > cpu->late_end) cpu->late_end = late;
+    }
+    if (late > cpu->loop + tolerance) cpu->late_exits++;
+}
+
+void retrace_run_until(const uint64_t now, const uint64_t board_at, const bool settling) {
+    // The board left the retimed frame by board_at at the latest
+    if (settling || rt.settling) rt.settled = board_at;
+    rt.settling = settling;
+    if (hal_host.clock_freq <= 0) return;
+    const uint64_t tolerance = (uint64_t) (hal_host.sys_hz / hal_host.clock_freq) + 1;
+    while (true) {
+        retrace_cpu_t *cpu = rt.cpu[0].next <= rt.cpu[1].next ? &rt.cpu[0] : &rt.cpu[1];
+        if (cpu->next + tolerance > now) return;
+        run_in(cpu, tolerance);
+    }
+}
+
+bool retrace_report(void) {
+    const double us = 1e6 / hal_host.sys_hz;
+    bool ok = true;
+    printf("  3DAh %s, VSYNC pulses outside retimed frames %llu\n",
+           CGA_ISA_VRAM ? "through the ISA window" : "from the status engine", (unsigned long long) rt.retraces);
+    for (int i = 0; i < 2; i++) {
+        const retrace_cpu_t *cpu = &rt.cpu[i];
+        printf("  %-12s INs %llu: exact %llu, within a DOTCLK of an edge %llu, before the engine synced on new timings %llu, wrong %llu\n",
+               cpu->name, (unsigned long long) cpu->reads, (unsigned long long) cpu->exact,
+               (unsigned long long) cpu->near_edge, (unsigned long long) cpu->settling,
+               (unsigned long long) cpu->wrong);
+        printf("  %-12s retraces caught %llu, ended %llu; worst exit after the edge %.2f us (start), %.2f us (end), "
+               "pass %.2f us, later than that %llu\n",
+               "", (unsigned long long) cpu->caught, (unsigned long long) cpu->exits, cpu->late_start * us,
+               cpu->late_end * us, cpu->loop * us, (unsigned long long) cpu->late_exits);
+        // The pulse under way when the run ends may not have been caught yet
+        ok &= !cpu->wrong && !cpu->late_exits && cpu->reads && cpu->caught + 1 >= rt.retraces;
+    }
+    return ok;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// CGA.md's wait for vertical retrace ("Ожидание вертикальной обратной развертки") run
+// against the firmware on the simulated board, as a DOS program would run it:
+//
+//   while (!(inportb(0x3DA) & 0x08));  // until the retrace starts
+//   while (inportb(0x3DA) & 0x08);     // until it ends
+//
+// over and over, on an 8088 at 4.77 MHz and an AT at 8 MHz at once. On CGA_ISA_VRAM
+// boards each IN is a read of the window at ISA_VRAM_STATUS_ADDRESS, answered by the
+// read chain from the byte raster_status.pio keeps; on the others (where the board's
+// own 74HC244 answers the CPU) the engine's byte is read directly. Every read is held
+// against the CRTC model's DE and VSYNC at its time: a difference only passes within a
+// DOTCLK of an edge, or in the frame the timings were rewritten in and up to the RA0
+// edge the engine syncs on after it. Each loop exit is timed against the VSYNC edge it
+// waited for.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void retrace_init(uint64_t start);
+// The model's DE or VSYNC changed at `at`
+void retrace_edge(bool de, bool vsync, uint64_t at);
+// Issue every IN due a DOTCLK before `now` (both cores and the board have reached it);
+// `settling` while the CRTC runs a frame with rewritten timings at `board_at`
+void retrace_run_until(uint64_t now, uint64_t board_at, bool settling);
+
+// false on a wrong read, a retrace missed or a loop exit later than one pass of the loop
+bool retrace_report(void);
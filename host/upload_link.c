@@ -0,0 +1,233 @@
+#include "upload_link.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cga.h"
+#include "delta_codec.h"
+#include "hal.h"
+#include "upload_protocol.h"
+#include "video_memory.h"
+
+// Bandwidth an idle link can bank: about one 1 ms USB frame
+#define LINK_CREDIT_MAX 1024.0
+// FLIP plus both 8000-byte banks in two packets each
+#define FRAME_PACKETS 5
+#define FRAME_WIRE_BYTES (2 * GRAPHICS_BUFFER_SIZE + FRAME_PACKETS * (UPLOAD_HEADER_SIZE + UPLOAD_CRC_SIZE))
+
+typedef struct {
+    uint8_t data[UPLOAD_MAX_PACKET];
+    size_t size;
+    uint8_t type;
+} sent_packet_t;
+
+static struct {
+    uint32_t frames, frames_sent, frames_skipped;
+    int corrupt_packet;
+    bool delta;
+    uint8_t base[GRAPHICS_WINDOW_BYTES]; // Last frame sent, what a delta is taken against
+    uint32_t packets; // First transmissions
+
+    uint8_t *wire; // Host -> device bytes not yet read by the firmware
+    size_t wire_size, wire_pos, wire_cap;
+    double credit;
+    uint64_t last_cycles;
+
+    sent_packet_t sent[256]; // By sequence number, kept for resends
+    uint8_t next_seq;        // Sequence number of the next new packet
+    uint8_t unacked;         // Oldest sequence number not acknowledged yet
+    int rewound_to;          // Sequence number of the last go-back-N, -1 if none
+    uint8_t last_phase;      // Pattern of the last frame sent
+
+    uint8_t reply[UPLOAD_REPLY_SIZE];
+    uint32_t reply_len;
+
+    uint64_t wire_bytes, payload_bytes, resent;
+    uint32_t acks, naks, rejects, flips_acked;
+    uint64_t first_cycles, last_ack_cycles;
+} link;
+
+static uint8_t frame_byte(const uint32_t bank, const uint32_t i, const uint8_t phase) {
+    if (link.delta) {
+        // Eight scanlines per bank, moving down a line per frame
+        const uint32_t line = i / 80, bar = phase % 92u;
+        return line >= bar && line < bar + 8 ? (uint8_t) (phase * 7 + i) : (uint8_t) (i * 13 + bank * 0x55);
+    }
+    return (uint8_t) (i * 13 + phase * 7 + bank * 0x55);
+}
+
+static void wire_put(const uint8_t *data, const size_t size) {
+    if (link.wire_size + size > link.wire_cap) {
+        link.wire_cap = (link.wire_size + size) * 2;
+        link.wire = realloc(link.wire, link.wire_cap);
+    }
+    memcpy(&link.wire[link.wire_size], data, size);
+    link.wire_size += size;
+    link.wire_bytes += size;
+}
+
+static void send_packet(const uint8_t type, const uint16_t offset, const uint8_t *payload, const uint16_t length) {
+    sent_packet_t *packet = &link.sent[link.next_seq];
+    packet->size = upload_encode(packet->data, type, link.next_seq, offset, payload, length);
+    packet->type = type;
+    link.next_seq++;
+    link.payload_bytes += length;
+
+    if ((int) link.packets++ == link.corrupt_packet) {
+        uint8_t damaged[UPLOAD_MAX_PACKET];
+        memcpy(damaged, packet->data, packet->size);
+        damaged[packet->size / 2] ^= 0x10;
+        wire_put(damaged, packet->size);
+    } else {
+        wire_put(packet->data, packet->size);
+    }
+}
+
+static void send_frame(const uint8_t phase) {
+    if (link.delta && link.frames_sent > 1) {
+        uint8_t frame[GRAPHICS_WINDOW_BYTES] = {0};
+        uint8_t stream[UPLOAD_MAX_PAYLOAD];
+        for (uint32_t bank = 0; bank < 2; bank++) {
+            for (uint32_t i = 0; i < GRAPHICS_BUFFER_SIZE; i++) {
+                frame[bank << GRAPHICS_INDEX_BITS | i] = frame_byte(bank, i, phase);
+            }
+        }
+        uint32_t start = 0, end;
+        size_t length;
+        while ((length = delta_encode(stream, sizeof(stream), link.base, frame, sizeof(frame), &start, &end))) {
+            send_packet(UPLOAD_GRAPHICS_DELTA, start, stream, length);
+            start = end;
+        }
+        memcpy(link.base, frame, sizeof(frame));
+        send_packet(UPLOAD_FLIP, 0, NULL, 0);
+        link.last_phase = phase;
+        return;
+    }
+
+    uint8_t bank_data[GRAPHICS_BUFFER_SIZE];
+    for (uint32_t bank = 0; bank < 2; bank++) {
+        for (uint32_t i = 0; i < GRAPHICS_BUFFER_SIZE; i++) {
+            bank_data[i] = frame_byte(bank, i, phase);
+        }
+        for (uint32_t offset = 0; offset < GRAPHICS_BUFFER_SIZE; offset += UPLOAD_MAX_PAYLOAD) {
+            const uint32_t length =
+                GRAPHICS_BUFFER_SIZE - offset < UPLOAD_MAX_PAYLOAD ? GRAPHICS_BUFFER_SIZE - offset : UPLOAD_MAX_PAYLOAD;
+            send_packet(UPLOAD_GRAPHICS, (bank << GRAPHICS_INDEX_BITS) + offset, &bank_data[offset], length);
+        }
+        memcpy(&link.base[bank << GRAPHICS_INDEX_BITS], bank_data, GRAPHICS_BUFFER_SIZE);
+    }
+    send_packet(UPLOAD_FLIP, 0, NULL, 0);
+    link.last_phase = phase;
+}
+
+// Put whatever is due by now on the wire
+static void produce(void) {
+    if (!link.packets) {
+        link.first_cycles = hal_host.cycles;
+        wire_put((const uint8_t *) "g", 1);
+        send_packet(UPLOAD_SYNC, 0, NULL, 0);
+    }
+    const double seconds = (double) (hal_host.cycles - link.first_cycles) / hal_host.sys_hz;
+    while (link.frames_sent + link.frames_skipped < link.frames &&
+           seconds >= (double) (link.frames_sent + link.frames_skipped) / UPLOAD_LINK_FPS) {
+        if (link.wire_size - link.wire_pos > FRAME_WIRE_BYTES) {
+            link.frames_skipped++;
+            continue;
+        }
+        send_frame((uint8_t) ++link.frames_sent);
+    }
+}
+
+void upload_link_init(const uint32_t frames, const int corrupt_packet, const bool delta) {
+    free(link.wire);
+    memset(&link, 0, sizeof(link));
+    link.frames = frames;
+    link.corrupt_packet = corrupt_packet;
+    link.delta = delta;
+    link.rewound_to = -1;
+}
+
+uint32_t upload_link_read(uint8_t *buf, const uint32_t max) {
+    produce();
+    link.credit += (double) (hal_host.cycles - link.last_cycles) * UPLOAD_LINK_BYTES_PER_SEC / hal_host.sys_hz;
+    link.last_cycles = hal_host.cycles;
+    if (link.credit > LINK_CREDIT_MAX) link.credit = LINK_CREDIT_MAX;
+
+    size_t count = link.wire_size - link.wire_pos;
+    if (count > max) count = max;
+    if (count > (size_t) link.credit) count = (size_t) link.credit;
+    memcpy(buf, &link.wire[link.wire_pos], count);
+    link.wire_pos += count;
+    link.credit -= (double) count;
+    if (link.wire_pos == link.wire_size) {
+        link.wire_pos = link.wire_size = 0;
+    }
+    return (uint32_t) count;
+}
+
+// Sequence number within the packets sent and not acknowledged yet
+static bool in_window(const uint8_t seq) {
+    return (uint8_t) (seq - link.unacked) < (uint8_t) (link.next_seq - link.unacked);
+}
+
+static void handle_reply(const uint8_t status, const uint8_t seq) {
+    if (status == UPLOAD_NAK) {
+        link.naks++;
+        // Every packet behind a bad one is NAKed with the same number: rewind once
+        if (seq == link.rewound_to || !in_window(seq)) return;
+        link.rewound_to = seq;
+        for (uint8_t s = seq; s != link.next_seq; s++) {
+            wire_put(link.sent[s].data, link.sent[s].size);
+            link.resent++;
+        }
+        return;
+    }
+    if (status == UPLOAD_REJECT) link.rejects++;
+    else link.acks++;
+    if (!in_window(seq)) return;
+    if (link.sent[seq].type == UPLOAD_FLIP) link.flips_acked++;
+    link.unacked = seq + 1;
+    link.rewound_to = -1;
+    link.last_ack_cycles = hal_host.cycles;
+}
+
+void upload_link_write(const uint8_t *buf, const uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        if (link.reply_len == 0 && buf[i] != UPLOAD_MAGIC0) continue; // Console text
+        link.reply[link.reply_len++] = buf[i];
+        if (link.reply_len == UPLOAD_REPLY_SIZE) {
+            link.reply_len = 0;
+            handle_reply(link.reply[1], link.reply[2]);
+        }
+    }
+}
+
+bool upload_link_idle(void) {
+    return link.frames_sent + link.frames_skipped == link.frames && link.unacked == link.next_seq &&
+           link.wire_pos == link.wire_size;
+}
+
+bool upload_link_report(void) {
+    const double streaming = (double) (link.last_ack_cycles - link.first_cycles) / hal_host.sys_hz;
+    printf("  upload frames sent %u, skipped %u, flips acknowledged %u (%.1f fps)\n", link.frames_sent,
+           link.frames_skipped, link.flips_acked, streaming > 0 ? link.flips_acked / streaming : 0.0);
+    printf("  upload wire %llu bytes (payload %llu, resent packets %llu), %.0f KB/s over %.3f s; "
+           "ACK %u, NAK %u, REJECT %u\n",
+           (unsigned long long) link.wire_bytes, (unsigned long long) link.payload_bytes,
+           (unsigned long long) link.resent, streaming > 0 ? link.wire_bytes / streaming / 1000 : 0.0, streaming,
+           link.acks, link.naks, link.rejects);
+
+    // The last frame sent must be the page on screen
+    const uint8_t page = cga_video_page();
+    uint32_t mismatches = 0;
+    for (uint32_t bank = 0; bank < 2; bank++) {
+        for (uint32_t i = 0; i < GRAPHICS_BUFFER_SIZE; i++) {
+            mismatches += graphics_buffer[page][bank][i] != frame_byte(bank, i, link.last_phase);
+        }
+    }
+    const bool idle = upload_link_idle();
+    printf("  upload %s, front page %u vs frame %u: %u byte(s) differ\n", idle ? "complete" : "NOT complete", page,
+           link.last_phase, mismatches);
+    return idle && !mismatches;
+}
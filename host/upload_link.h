@@ -0,0 +1,34 @@
+#pragma once
+
+// Host side of upload_protocol.h for cga_sim: a frame streamer talking to main.c on
+// the simulated board over a model of the USB CDC link.
+//
+// The link delivers at most UPLOAD_LINK_BYTES_PER_SEC of virtual time, the way a
+// full-speed bulk endpoint does, and only when the firmware reads: while core 0 holds
+// input back (a flip in flight) the bytes wait on the host side, as USB NAKs would
+// make them. The streamer switches to graphics mode with a console key, sends SYNC,
+// then one 320x200 frame (both banks, 16000 bytes) plus FLIP per 1/60 s, pipelined
+// without waiting for ACKs. A NAK rewinds to the sequence number it names (go-back-N).
+// A new frame is skipped while the previous one is still queued on the link.
+// In delta mode a bar moves over a fixed picture, and every frame after the first is
+// sent as delta_codec.h streams against the last frame sent.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define UPLOAD_LINK_BYTES_PER_SEC 1000000.0
+#define UPLOAD_LINK_FPS 60
+
+// Stream `frames` frames; corrupt_packet >= 0 flips a bit in that packet on the wire once
+void upload_link_init(uint32_t frames, int corrupt_packet, bool delta);
+
+// hal_host.console_read / console_write
+uint32_t upload_link_read(uint8_t *buf, uint32_t max);
+void upload_link_write(const uint8_t *buf, uint32_t len);
+
+// Every packet acknowledged
+bool upload_link_idle(void);
+
+// Print the link statistics and compare the page on screen with the last frame sent;
+// false if something is still outstanding or differs
+bool upload_link_report(void);
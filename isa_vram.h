@@ -0,0 +1,152 @@
+#pragma once
+
+// ISA memory window at B8000h served by the RP2040 itself (CGA_ISA_VRAM boards).
+// Pure C, shared by the firmware and the host tools.
+//
+// On the original board isa-vram.pld decodes the CPU cycle and two 6164s answer it;
+// the RP2040 never sees a CPU write. On this board revision the RP2040 replaces the
+// SRAMs and pld/isa-vram-rp2040.pld and pld/isa-io-rp2040.pld replace the two
+// decoders: the window decode is the same, its /VRAMOE and /VRAMWR reach GPIO26/29,
+// the ISA address comes in on GPIO0..13 (the VRAM side of the address transceivers)
+// and the data on D0..D7.
+// Reads are answered by PIO + DMA from the same buffers the fetch engine scans out,
+// writes are captured by PIO and stored by core 1 (isa_vram.pio).
+//
+// isa_vram_decode() is isa-vram.pld equation for equation. The window mapping below
+// is what those equations do to the two 6164s, folded onto the RP2040 buffers:
+//   text (GSEL=0):     bank = A0 (char/attr), VRAMA0 = 0 -> text_buffer[A0..A11]
+//                      (4 KB: the window repeats every 4 KB, the 6164s every 8 KB)
+//   graphics (GSEL=1): bank = A13, VRAMA0 = A0         -> graphics_buffer[A13][A0..A12]
+// A14 is not decoded, BC000-BFFFF mirrors B8000-BBFFF as on a real CGA.
+//
+// The MC6845 cannot be reached from the ISA bus on this board, so writes to
+// 3D4h/3D5h/3D8h/3D9h come the same way: isa-io-rp2040.pld decodes the port,
+// isa-vram-rp2040.pld pulls /VRAMOE and /VRAMWR low together (no memory cycle does
+// that) and puts A0..A7 on the mux from the address alone, before /IOW. The
+// write capture samples /VRAMOE with the address and core 1 hands the write to core 0
+// (cga_io.h).
+//
+// An IN from 3DAh needs no CPU either. There is no 74HC244 on this revision:
+// isa-io-rp2040.pld's /STATRD makes isa-vram-rp2040.pld pull /VRAMOE low alone, as a
+// memory read would, with the A8..A13 half of the address buffers off (/ISAHI), so the
+// pull-ups on VA8..VA13 put ISA_VRAM_STATUS_ADDRESS on the mux. The read chain answers
+// it from that byte of the window (isa_vram_status_byte()), which raster_status.pio
+// keeps up to date by DMA; the byte is taken out of video memory (see the window
+// mapping).
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "video_memory.h"
+
+// ---------------- isa-vram.pld ----------------
+
+typedef struct {
+    bool cpu_access; // /CPUACCESS low: a CPU address in B8000-BFFFF (/MC6845ACCESS high)
+    bool bank0;      // /BANK0CS low
+    bool bank1;      // /BANK1CS low
+    bool oe;         // /VRAMOE low
+    bool wr;         // /VRAMWR low
+    bool vram_a0;    // VRAMA0
+} isa_vram_decode_t;
+
+// memr/memw are the asserted (low) states of /MEMR and /MEMW, gsel is 3D8h graphics
+static inline isa_vram_decode_t isa_vram_decode(const uint32_t address, const bool memr, const bool memw,
+                                                const bool gsel) {
+    const bool a0 = address & 1, a13 = address >> 13 & 1;
+    isa_vram_decode_t d;
+    d.cpu_access = (address >> 15 & 0x1F) == 0x17; // A19 * /A18 * A17 * A16 * A15
+    d.bank0 = d.cpu_access && !(gsel ? a13 : a0);
+    d.bank1 = d.cpu_access && (gsel ? a13 : a0);
+    d.oe = d.cpu_access && memr;
+    d.wr = d.cpu_access && memw;
+    d.vram_a0 = gsel && a0;
+    return d;
+}
+
+// isa-io-rp2040.pld /REGWR: an OUT that reaches the RP2040 as a register cycle (A9..A0 decoded only)
+static inline bool isa_vram_io_decode(const uint16_t port) {
+    const uint16_t a = port & 0x3FF;
+    return (a & 0x3F0) == 0x3D0 && ((a & 0xE) == 0x4 || (a & 0xE) == 0x8); // /CRTCCS, /MODEREGCE, /COLORREGCE
+}
+
+// ---------------- Window mapping ----------------
+
+// What the read chain indexes with A0..A(index_bits-1): table | offset, the same
+// base | index pointer arithmetic as the video DMA chain.
+//
+// Every window is video memory but one byte, ISA_VRAM_STATUS_ADDRESS: the 14 bits of
+// the mux leave no address a 3DAh read could use that a memory read cannot, so the
+// status lives in the window. That byte reads as 3DAh, and CPU writes to it (B800:0FDA
+// and its 4 KB mirrors in text, B800:3FDA in graphics) are dropped (isa_vram_store()).
+// It is off screen at every page start the BIOS uses: past an 80x25 page and the
+// second 40x25 page in text, past the 8000 bytes of the odd bank in graphics, and even
+// (a character, not an attribute) in the 160x100 tweak mode. Only R12/R13 scrolled to
+// the end of the window brings it into view: in graphics as the live status bits, in
+// text as cell 2029 with the status byte it held when last expanded.
+typedef struct {
+    uint8_t *table; // Aligned to 1 << index_bits
+    uint8_t index_bits;
+} isa_vram_window_t;
+
+#define ISA_VRAM_TEXT_BITS     (TEXT_INDEX_BITS + 1)                    // TEXT_WINDOW_BYTES
+#define ISA_VRAM_GRAPHICS_BITS (GRAPHICS_INDEX_BITS + GRAPHICS_BANK_BITS) // GRAPHICS_WINDOW_BYTES
+
+static inline isa_vram_window_t isa_vram_window(const video_window_t window, const uint8_t page) {
+    if (window == VIDEO_WINDOW_GRAPHICS) {
+        return (isa_vram_window_t) {graphics_buffer[page][0], ISA_VRAM_GRAPHICS_BITS};
+    }
+    return (isa_vram_window_t) {text_buffer[page], ISA_VRAM_TEXT_BITS};
+}
+
+// 3DAh with A8..A13 pulled high: 0FDAh into a text window, 3FDAh into a graphics one
+#define ISA_VRAM_STATUS_ADDRESS 0x3FDA
+
+static inline uint8_t *isa_vram_status_byte(const isa_vram_window_t *window) {
+    return window->table + (ISA_VRAM_STATUS_ADDRESS & ((1u << window->index_bits) - 1));
+}
+
+// The window byte that holds 3DAh instead of video memory
+static inline bool isa_vram_reserved(const uint8_t index_bits, const uint32_t address) {
+    return !((address ^ ISA_VRAM_STATUS_ADDRESS) & ((1u << index_bits) - 1));
+}
+
+static inline uint8_t isa_vram_lookup(const isa_vram_window_t *window, const uint32_t address) {
+    return *(const uint8_t *) ((uintptr_t) window->table | (address & ((1u << window->index_bits) - 1)));
+}
+
+// Core 1's half of a CPU write: the byte goes into the page on screen, a text cell is
+// re-expanded into the row planes with its other half, an attribute in the graphics
+// window into the tweak cells. A write to the status byte goes nowhere.
+static inline void isa_vram_store(const video_window_t window, const uint8_t page, const uint32_t address,
+                                  const uint8_t value) {
+    if (isa_vram_reserved(window == VIDEO_WINDOW_GRAPHICS ? ISA_VRAM_GRAPHICS_BITS : ISA_VRAM_TEXT_BITS, address)) {
+        return;
+    }
+    if (window == VIDEO_WINDOW_GRAPHICS) {
+        graphics_buffer[page][address >> GRAPHICS_INDEX_BITS & 1][address & ((1 << GRAPHICS_INDEX_BITS) - 1)] = value;
+        video_tweak_put_page(page, address, value);
+        return;
+    }
+    const uint32_t offset = address & (TEXT_WINDOW_BYTES - 1);
+    text_buffer[page][offset] = value;
+    const uint32_t cell = offset >> 1;
+    video_text_put_page(page, cell, text_buffer[page][2 * cell], text_buffer[page][2 * cell + 1]);
+}
+
+// ---------------- Response times (sys_clk cycles at SYSTEM_CLOCK_HZ) ----------------
+// Read, /VRAMOE falling to the byte on D0..D7: input synchroniser 2, wait + two `in`
+// (autopush) 3, reader DMA (DREQ, FIFO read, trigger write) 4, lookup DMA (SRAM read,
+// TX FIFO write) 4, pull + mov pins 2, output 1.
+#define ISA_VRAM_READ_CYCLES 16
+// The DMA has bus priority but still waits out a core access to the same SRAM bank
+#define ISA_VRAM_READ_STALL_CYCLES 4
+// PLD propagation (ATF16V8B-10) plus the data transceiver, both ways round
+#define ISA_VRAM_READ_EXTERNAL_NS 25
+// Write, /VRAMWR falling to the capture: synchroniser 2, wait [31] for the ISA data
+// to settle on D0..D7 once the bus engine has released them, `in` 1
+#define ISA_VRAM_WRITE_SAMPLE_CYCLES 35
+// isa_vram_store() on core 1: the status byte test, then a graphics byte (and its
+// tweak cell), or a text cell and its 8 row planes
+#define ISA_VRAM_STORE_CYCLES_GRAPHICS 17
+#define ISA_VRAM_STORE_CYCLES_TEXT 43
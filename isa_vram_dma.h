@@ -0,0 +1,78 @@
+#pragma once
+
+// DMA behind the ISA window engine (isa_vram_pio.h). No CPU involvement per read:
+//
+//   isa_vram_read RX --[base | A]--> byte.READ_ADDR_TRIG
+//   byte:  window[A] -------------> isa_vram_read TX (the byte, replicated)
+//
+// the same two-channel ring as the video chain (video_dma.h). A second pair of
+// channels keeps isa_vram_bus fed with its two-word instruction ring: each moves
+// ISA_VRAM_BUS_RING_WORDS and chains to the other, so neither ever runs dry.
+
+#include "hardware/dma.h"
+
+#include "isa_vram.h"
+#include "isa_vram_pio.h"
+#include "video_dma.h"
+
+// Even, so either channel picks the ring up on the word the other one stopped at
+#define ISA_VRAM_BUS_RING_WORDS 0xFFFFFFFEu
+
+typedef struct {
+    int addr, byte;
+    int bus[2];
+    uint read_offset; // isa_vram_read, for the per-window patching
+} isa_vram_dma_t;
+
+static isa_vram_dma_t isa_vram_dma;
+static uint32_t isa_vram_bus_ring[2] __attribute__((aligned(8)));
+
+__always_inline static void isa_vram_dma_set_window(const isa_vram_window_t *window) {
+    isa_vram_read_set_window(PIO_ISA, SM_ISA_READ, isa_vram_dma.read_offset, (uintptr_t) window->table,
+                             window->index_bits);
+}
+
+static inline void isa_vram_dma_bus_ring(const int channel, const int other) {
+    dma_channel_config c = dma_channel_get_default_config(channel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_ring(&c, false, 3); // 8 bytes: the two words
+    channel_config_set_dreq(&c, pio_get_dreq(PIO_ISA, SM_ISA_BUS, true));
+    channel_config_set_chain_to(&c, other);
+    dma_channel_configure(channel, &c, &PIO_ISA->txf[SM_ISA_BUS], isa_vram_bus_ring, ISA_VRAM_BUS_RING_WORDS, false);
+}
+
+static inline void isa_vram_dma_init(const uint addr_pin_base, const uint data_pin_base, const uint oe_pin,
+                                     const uint wr_pin, const isa_vram_window_t *window) {
+    isa_vram_bus_ring[0] = pio_encode_wait_gpio(false, wr_pin) | 0x00u << 16;
+    isa_vram_bus_ring[1] = pio_encode_wait_gpio(true, wr_pin) | 0xFFu << 16;
+
+    // /VRAMOE and /VRAMWR are inputs from the PLD; only the PIOs sample them
+    gpio_init(oe_pin);
+    gpio_init(wr_pin);
+
+    isa_vram_dma.read_offset = pio_add_program(PIO_ISA, &isa_vram_read_program);
+    isa_vram_read_program_init(PIO_ISA, SM_ISA_READ, isa_vram_dma.read_offset, addr_pin_base, data_pin_base, oe_pin);
+    isa_vram_bus_program_init(PIO_ISA, SM_ISA_BUS, pio_add_program(PIO_ISA, &isa_vram_bus_program), data_pin_base);
+    isa_vram_write_program_init(PIO_ISA_WRITE, SM_ISA_WRITE, pio_add_program(PIO_ISA_WRITE, &isa_vram_write_program),
+                                addr_pin_base);
+
+    isa_vram_dma.addr = dma_claim_unused_channel(true);
+    isa_vram_dma.byte = dma_claim_unused_channel(true);
+    video_dma_ring_reader(isa_vram_dma.addr, isa_vram_dma.byte, PIO_ISA, SM_ISA_READ);
+    video_dma_ring_lookup(isa_vram_dma.byte, isa_vram_dma.addr, PIO_ISA, SM_ISA_READ);
+
+    isa_vram_dma.bus[0] = dma_claim_unused_channel(true);
+    isa_vram_dma.bus[1] = dma_claim_unused_channel(true);
+    isa_vram_dma_bus_ring(isa_vram_dma.bus[0], isa_vram_dma.bus[1]);
+    isa_vram_dma_bus_ring(isa_vram_dma.bus[1], isa_vram_dma.bus[0]);
+
+    // The read chain must not wait behind the CPUs on the bus fabric
+    bus_ctrl_hw->priority = BUSCTRL_BUS_PRIORITY_DMA_W_BITS | BUSCTRL_BUS_PRIORITY_DMA_R_BITS;
+
+    isa_vram_dma_set_window(window);
+    dma_start_channel_mask(1u << isa_vram_dma.addr | 1u << isa_vram_dma.bus[0]);
+    pio_enable_sm_mask_in_sync(PIO_ISA, 1u << SM_ISA_READ | 1u << SM_ISA_BUS);
+    pio_sm_set_enabled(PIO_ISA_WRITE, SM_ISA_WRITE, true);
+}
@@ -0,0 +1,159 @@
+// Maintained by hand; the build does not run pioasm. isa_vram.pio is the source of
+// truth for the three programs, and their tables, wraps and default configs here are
+// its pioasm output, pasted in again after each edit. The patch offsets of the two
+// `in` of isa_vram_read must follow the program, and the SM layout and helpers below
+// them are hand-written.
+
+#pragma once
+
+#if !PICO_NO_HARDWARE
+#include "hardware/pio.h"
+#endif
+
+// Read and bus direction share pio0 with the video engine (they drive D0..D7);
+// the read SM is numbered above video_data so it wins a same-cycle pin write
+#define PIO_ISA pio0
+#define SM_ISA_BUS 1
+#define SM_ISA_READ 3
+// The write capture only samples pins
+#define PIO_ISA_WRITE pio1
+#define SM_ISA_WRITE 2
+
+// ------------- //
+// isa_vram_read //
+// ------------- //
+
+#define isa_vram_read_wrap_target 4
+#define isa_vram_read_wrap 5
+
+// Instructions rewritten with the window's index width
+#define isa_vram_read_offset_base_bits 1
+#define isa_vram_read_offset_index_bits 2
+
+static const uint16_t isa_vram_read_program_instructions[] = {
+    0x201a, //  0: wait   0 gpio, 26
+    0x4032, //  1: in     x, 18
+    0x400e, //  2: in     pins, 14
+    0x80a0, //  3: pull   block
+            //     .wrap_target
+    0xa007, //  4: mov    pins, osr
+    0x00c0, //  5: jmp    pin, 0
+            //     .wrap
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program isa_vram_read_program = {
+    .instructions = isa_vram_read_program_instructions,
+    .length = 6,
+    .origin = -1,
+};
+
+static inline pio_sm_config isa_vram_read_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + isa_vram_read_wrap_target, offset + isa_vram_read_wrap);
+    return c;
+}
+#endif
+
+// ------------ //
+// isa_vram_bus //
+// ------------ //
+
+#define isa_vram_bus_wrap_target 0
+#define isa_vram_bus_wrap 1
+
+static const uint16_t isa_vram_bus_program_instructions[] = {
+            //     .wrap_target
+    0x60f0, //  0: out    exec, 16
+    0x6088, //  1: out    pindirs, 8
+            //     .wrap
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program isa_vram_bus_program = {
+    .instructions = isa_vram_bus_program_instructions,
+    .length = 2,
+    .origin = -1,
+};
+
+static inline pio_sm_config isa_vram_bus_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + isa_vram_bus_wrap_target, offset + isa_vram_bus_wrap);
+    return c;
+}
+#endif
+
+// -------------- //
+// isa_vram_write //
+// -------------- //
+
+#define isa_vram_write_wrap_target 0
+#define isa_vram_write_wrap 2
+
+static const uint16_t isa_vram_write_program_instructions[] = {
+            //     .wrap_target
+    0x3f1d, //  0: wait   0 gpio, 29             [31]
+    0x401b, //  1: in     pins, 27
+    0x209d, //  2: wait   1 gpio, 29
+            //     .wrap
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program isa_vram_write_program = {
+    .instructions = isa_vram_write_program_instructions,
+    .length = 3,
+    .origin = -1,
+};
+
+static inline pio_sm_config isa_vram_write_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + isa_vram_write_wrap_target, offset + isa_vram_write_wrap);
+    return c;
+}
+
+// A0..A13 in, the byte out on D0..D7 (their directions belong to video_data and
+// isa_vram_bus); call isa_vram_read_set_window() before enabling
+static inline void isa_vram_read_program_init(PIO pio, uint sm, uint offset, uint addr_pin_base, uint data_pin_base,
+                                              uint oe_pin) {
+    pio_sm_config c = isa_vram_read_program_get_default_config(offset);
+    sm_config_set_in_pins(&c, addr_pin_base);
+    sm_config_set_out_pins(&c, data_pin_base, 8);
+    sm_config_set_jmp_pin(&c, oe_pin);
+    sm_config_set_in_shift(&c, false, true, 32);
+    sm_config_set_out_shift(&c, true, false, 32);
+    pio_sm_init(pio, sm, offset, &c);
+}
+
+// Point the read at a new window: patch the index width, restart, load X with the base
+__always_inline static void isa_vram_read_set_window(PIO pio, uint sm, uint offset, uintptr_t base, uint index_bits) {
+    const bool enabled = pio->ctrl & (1u << sm);
+    pio_sm_set_enabled(pio, sm, false);
+    pio->instr_mem[offset + isa_vram_read_offset_base_bits] = pio_encode_in(pio_x, 32 - index_bits);
+    pio->instr_mem[offset + isa_vram_read_offset_index_bits] = pio_encode_in(pio_pins, index_bits);
+    pio_sm_clear_fifos(pio, sm);
+    pio_sm_restart(pio, sm);
+    pio_sm_put(pio, sm, base >> index_bits);
+    pio_sm_exec(pio, sm, pio_encode_pull(false, true));
+    pio_sm_exec(pio, sm, pio_encode_out(pio_x, 32));
+    pio_sm_exec(pio, sm, pio_encode_jmp(offset));
+    pio_sm_set_enabled(pio, sm, enabled);
+}
+
+// Instructions and pin directions from the DMA ring, 24 bits per word
+static inline void isa_vram_bus_program_init(PIO pio, uint sm, uint offset, uint data_pin_base) {
+    pio_sm_config c = isa_vram_bus_program_get_default_config(offset);
+    sm_config_set_out_pins(&c, data_pin_base, 8);
+    sm_config_set_out_shift(&c, true, true, 24);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    pio_sm_init(pio, sm, offset, &c);
+}
+
+// GPIO0..26 sampled into the RX FIFO, at full sys_clk for the settle delay to hold
+static inline void isa_vram_write_program_init(PIO pio, uint sm, uint offset, uint addr_pin_base) {
+    pio_sm_config c = isa_vram_write_program_get_default_config(offset);
+    sm_config_set_in_pins(&c, addr_pin_base);
+    sm_config_set_in_shift(&c, false, true, 27);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+    pio_sm_init(pio, sm, offset, &c);
+}
+#endif
@@ -1,291 +1,729 @@
 // MC6845 + RP2040 interface
 // Cleaned up, more readable version
-// Requires Pico SDK
+// Requires Pico SDK (or CGA_HOST=1 for the simulated board, see hal.h)
 // https://cpctech.cpcwiki.de/docs/mc6845/mc6845.htm
 // https://minuszerodegrees.net/mda_cga_ega/mda_cga_ega.htm
 // https://www.minuszerodegrees.net/oa/OA%20-%20IBM%20Color%20Graphics%20Monitor%20Adapter%20%28CGA%29.pdf
 
 #include <stdio.h>
-#include "pico/time.h"
-#include "pico/stdio_usb.h"
-#include "hardware/gpio.h"
-#include "hardware/pio.h"
-#include <hardware/structs/vreg_and_chip_reset.h>
+#include <string.h>
+
+#include "board.h"
+#include "cga.h"
+#include "cga_io.h"
+#include "core_mailbox.h"
+#include "crtc_shadow.h"
+#include "hal.h"
+#include "isa_vram.h"
+#include "upload_protocol.h"
+#include "video_memory.h"
+#include "video_modes.h"
+#include "video_registry.h"
+
+// Core 0: console and mode switching. Core 1: video fetches and the MC6845 bus.
+// Everything core 0 wants done on the bus goes through the mailbox.
+static video_mode_t current_video_mode = VIDEO_MODE_TEXT_80x25;
+static video_mode_t fetch_mode = VIDEO_MODE_TEXT_80x25; // Core 1's copy of current_video_mode
+static const video_mode_desc_t *fetch_desc;             // Its descriptor, activated by core 1
+static video_fetch_kernel_t fetch_kernel;               // fetch_desc->fetch, for the fetch loop
+static const void *fetch_table;                         // Its table on fetch_page, for the kernel
+static uint8_t fetch_page = 0; // Front page, written by core 1 only
+static core_mailbox_t mailbox;
+
+// Core 1: staged register sets and fetch mode, applied together in vertical blank
+static crtc_shadow_t crtc_shadow;
+static video_mode_t staged_fetch_mode = VIDEO_MODE_TEXT_80x25;    // Open set
+static video_mode_t committed_fetch_mode = VIDEO_MODE_TEXT_80x25; // Goes out in the next blank
+static uint8_t staged_page = 0, committed_page = 0;
+static bool flushing;     // Blank was seen, pending writes are going out
+static bool frame_armed;  // Row 0 seen since the last counted blank
+static bool blank_open;   // In a blank entered from row 0, nothing sent in it yet
+static uint32_t video_frames; // Written by core 1 only
+
+// The blank test reads MA with a plain GPIO read, at any point of the character. For up
+// to tMAD (160 ns) after CLK the MC6845 is still moving MA and a read can return any mix
+// of old and new bits: 1023 -> 1024 may read as 2047, inside the 80x25 blank. A region
+// only counts once every read for MA_SETTLE_US has agreed on it; that spans more than a
+// character, so at least one of those reads saw settled MA (the timer counts whole us).
+#define MA_SETTLE_US 3
+typedef enum { MA_DISPLAY, MA_FIRST_ROW, MA_BLANK } ma_region_t;
+static ma_region_t ma_region = MA_DISPLAY;
+static uint64_t ma_region_since;
+static uint32_t ma_region_pins; // Previous read in row 0
+
+// 3DAh: where the raster was at a known time, taken by core 1 on the first character of
+// row 0 it sees in each frame; readers count on from it (cga_io.h). seq is odd while
+// core 1 is writing.
+typedef struct {
+    uint32_t seq;
+    uint64_t us;
+    uint32_t chars; // Character clocks into the frame at `us`
+    uint32_t rate;  // Character clocks per us, 16.16
+    uint8_t regs[16];
+} raster_anchor_t;
+static raster_anchor_t raster_anchor;
+
+// 3DAh fast path (raster_status.pio): the frame as a DE/VSYNC timeline, rebuilt a line
+// per pass whenever new timings are on the chip and started on the next row 0. Until
+// it runs, reads fall back on the anchor above.
+#define RASTER_TIMELINE_WORDS 1024 // Two per displayed scanline and a few more
+static uint32_t raster_timeline[RASTER_TIMELINE_WORDS];
+static struct {
+    uint8_t regs[16]; // Timings the timeline is built for
+    uint32_t line;    // Next line to build, 1..frame lines (the last is line 0)
+    uint32_t words;
+    bool building;
+    bool built;       // Complete, waits for row 0
+    bool starting;    // Started on line 0, syncs on the RA0 edge that ends it
+    bool live;        // The engine plays it; read by core 0 as well
+} raster;
+#if !CGA_ISA_VRAM
+static uint8_t raster_status_byte = CGA_STATUS_IDLE; // Where the engine stores 3DAh
+#endif
+#if CGA_ISA_VRAM
+static core_mailbox_t io_mailbox; // 3Dxh writes from the ISA bus, core 1 -> core 0
+#endif
 
-#include "clock_pio.h"
-#include "rom.h"
+// ==========================================================
+// Register access
+// ==========================================================
 
-// ---------------- Pin assignments ----------------
-#define PIN_MC6845_CS     26  // Chip Select (active low)
-#define PIN_MC6845_RS     27  // Register Select (0=address, 1=data)
-#define PIN_MC6845_E      28  // Enable (active edge high->low)
-#define PIN_MC6845_RW     29  // Read/Write (0=write, 1=read)
-#define PIN_MC6845_CLK    25  // Clock output pin
+// The bus cycle itself (CS, RS, E strobes, address then data) is clocked out by the
+// PIO write engine; the CPU only queues the pair. Callers check hal_crtc_write_ready().
+__always_inline static void mc6845_write_register(const uint8_t reg, const uint8_t value) {
+    hal_crtc_write(reg & 0x1F, value);
+}
 
-#define PIN_MA_BASE       0   // MA0..MA13 → GPIO0..13 (MC6845 address inputs - read only)
-#define MA_WIDTH          14
+// ==========================================================
+// Initialization
+// ==========================================================
 
-#define PIN_RA_BASE       14  // RA0..RA2 → GPIO14..16 (MC6845 row address inputs - read only)
-#define RA_WIDTH          3
+static void init_all_gpio(void) {
+    // MC6845 control pins; CS/RS/E are handed to the write engine below, RW stays a write.
+    // With the ISA window CS and RW are strapped on the board and their pins are inputs.
+    for (int i = 0; i < 4; i++) {
+        const uint8_t mc6845_pins[] = {PIN_MC6845_CS, PIN_MC6845_RS, PIN_MC6845_E, PIN_MC6845_RW};
+        hal_gpio_init(mc6845_pins[i]);
+        if (CGA_ISA_VRAM && (mc6845_pins[i] == PIN_ISA_VRAMOE || mc6845_pins[i] == PIN_ISA_VRAMWR)) continue;
+        hal_gpio_set_dir(mc6845_pins[i], HAL_GPIO_OUT);
+    }
+    hal_gpio_put(PIN_MC6845_CS, 1);
+    hal_gpio_put(PIN_MC6845_E, 0);
+    hal_gpio_put(PIN_MC6845_RW, 0);
 
-#define PIN_DATA_BASE     17  // D0 = GPIO17 .. D7 = GPIO24 (MC6845 data bus)
-#define DATA_WIDTH        8
+    // Data bus + Address monitoring
+    for (int i = 0; i < 25; i++) {
+        hal_gpio_init(i);
+        hal_gpio_set_dir(i, i < 17 ? HAL_GPIO_IN : HAL_GPIO_OUT);
+    }
 
-// ---------------- System configuration ----------------
-#define SYSTEM_CLOCK_HZ       (400 * MHZ)  // 400 MHz RP2040 core
+    fetch_desc = video_mode_desc(current_video_mode);
+    fetch_kernel = fetch_desc->fetch;
+    hal_clock_init(PIN_MC6845_CLK, fetch_desc->dotclk_hz);
+
+    // MA/RA capture and D0..D7 output state machines
+    const video_dma_layout_t layout = video_mode_layout(fetch_desc, fetch_page);
+    fetch_table = layout.table;
+#if VIDEO_FETCH_DMA
+    hal_video_dma_init(PIN_MA_BASE, PIN_DATA_BASE, &layout);
+#else
+    hal_video_init(PIN_MA_BASE, PIN_DATA_BASE);
+#endif
+
+    // Register write engine (CS/RS/E from PIN_MC6845_CS up, D0..D7 shared with video)
+    hal_crtc_write_init(PIN_MC6845_CS, PIN_DATA_BASE);
+
+#if CGA_ISA_VRAM
+    // CPU reads and writes of B8000h; takes the CS pin back from the write engine
+    const isa_vram_window_t window = isa_vram_window(fetch_desc->window, fetch_page);
+    hal_isa_vram_init(PIN_MA_BASE, PIN_DATA_BASE, PIN_ISA_VRAMOE, PIN_ISA_VRAMWR, &window);
+    // 3DAh reads are answered from the window as well
+    hal_raster_init(PIN_RA_BASE, isa_vram_status_byte(&window));
+#else
+    hal_raster_init(PIN_RA_BASE, &raster_status_byte);
+#endif
 
-// 80x25 (640x200) = 14.31818Mhz, 40x25 (320x200) = 7.15909Mhz
-#define CLOCK_FREQ_TEXT       (14.31818 * MHZ)  // Для 80x25 текстового режима
-#define CLOCK_FREQ_GRAPHICS   (7.15909 * MHZ)   // Для 40x25 и графического режима
+    // Setup MC6845 registers
+    for (int r = 0; r < 16; r++) {
+        while (!hal_crtc_write_ready()) {
+            hal_crtc_write_poll();
+        }
+        mc6845_write_register(r, fetch_desc->crtc[r]);
+    }
+    crtc_shadow_init(&crtc_shadow, fetch_desc->crtc);
+}
 
-// ---------------- Video modes ----------------
-typedef enum {
-    VIDEO_MODE_TEXT_80x25 = 0,
-    VIDEO_MODE_TEXT_40x25 = 1,
-    VIDEO_MODE_GRAPHICS = 2
-} video_mode_t;
+// Serve every MA/RA sample captured by the PIO. The byte goes out VIDEO_DATA_LATENCY
+// DOTCLKs after the capture, so only the lookup itself has to keep up.
+// VIDEO_FETCH_ASM runs the same loop in assembly, video_fetch.S.
+// With the DMA chain there is nothing to do here.
+__always_inline static void service_video_fetches(void) {
+#if VIDEO_FETCH_ASM
+    hal_video_fetch_loop(fetch_desc->loop, fetch_table);
+#elif !VIDEO_FETCH_DMA
+    while (hal_video_addr_pending()) {
+        hal_video_data_put(fetch_kernel(fetch_table, hal_video_addr_get()));
+    }
+#endif
+}
 
-static video_mode_t current_video_mode = VIDEO_MODE_TEXT_80x25;
-static float current_clock_freq = CLOCK_FREQ_TEXT;
+// CPU writes to B8000h captured by the PIO: into the page on screen, the one the
+// read chain answers from. Core 1 owns fetch_mode and fetch_page, so a write never
+// lands in a page that has just been flipped away. A 3Dxh register write comes with
+// /VRAMOE low as well and goes to core 0; with the mailbox full it is lost.
+__always_inline static void service_isa_writes(void) {
+#if CGA_ISA_VRAM
+    while (hal_isa_vram_write_pending()) {
+        const uint32_t sample = hal_isa_vram_write_get();
+        const uint8_t value = sample >> PIN_DATA_BASE & 0xFF;
+        if (!(sample & 1u << PIN_ISA_VRAMOE)) {
+            core_mailbox_try_post(&io_mailbox, core_mailbox_message(CORE_MAILBOX_IO_WRITE, sample & 0xF, value));
+            continue;
+        }
+        isa_vram_store(fetch_desc->window, fetch_page, sample & ((1u << MA_WIDTH) - 1), value);
+    }
+#endif
+}
 
-// ---------------- Video memory emulation ----------------
-#define TEXT_BUFFER_SIZE (80 * 25)
-#define GRAPHICS_BUFFER_SIZE (8000)  // 320x200/4 pixels per byte
+// Activate fetch_mode's descriptor on fetch_page: DOTCLK if the mode changed, then the
+// fetch engine (and the ISA window, GSEL = graphics) on its buffers. Core 1 runs this in
+// the blank on every flip, so it and everything it calls stay out of flash.
+static void __not_in_flash_func(apply_fetch_mode)(void) {
+    const video_mode_desc_t *desc = video_mode_desc(fetch_mode);
+    if (desc != fetch_desc) {
+        hal_clock_set_div(desc->clkdiv);
+        fetch_desc = desc;
+        fetch_kernel = desc->fetch;
+    }
+    const video_dma_layout_t layout = video_mode_layout(fetch_desc, fetch_page);
+    fetch_table = layout.table;
+#if VIDEO_FETCH_DMA
+    hal_video_dma_set_layout(&layout);
+#endif
+#if CGA_ISA_VRAM
+    const isa_vram_window_t window = isa_vram_window(fetch_desc->window, fetch_page);
+    hal_isa_vram_set_window(&window);
+    hal_raster_set_target(isa_vram_status_byte(&window));
+#endif
+}
 
-// Simple test patterns for demonstration
-static uint8_t text_buffer[TEXT_BUFFER_SIZE];
-static uint8_t graphics_buffer[GRAPHICS_BUFFER_SIZE];
-// Атрибуты задаются перемычками, не хранятся в RP2040
+// ==========================================================
+// Core 1: video service loop
+// ==========================================================
 
-// Test pattern generation
-static void init_test_patterns(void) {
-    // Text mode: Fill with test characters
-    for (int i = 0; i < TEXT_BUFFER_SIZE; i++) {
-        text_buffer[i] = 0x20 + (i % 96); // ASCII printable chars
-        // Атрибуты будут браться из перемычек
-    }
+// Row 0 is on MA/RA: publish the raster position for 3DAh reads
+static void __not_in_flash_func(anchor_raster)(const uint32_t pins, const uint32_t ma) {
+    raster_anchor_t *anchor = &raster_anchor;
+    const uint32_t ra = pins >> PIN_RA_BASE & ((1u << RA_WIDTH) - 1);
+    __atomic_store_n(&anchor->seq, anchor->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    anchor->us = hal_time_us();
+    anchor->chars = ra * (crtc_shadow.regs[0] + 1u) + crtc_shadow_frame_offset(&crtc_shadow, ma);
+    anchor->rate = fetch_desc->char_rate;
+    memcpy(anchor->regs, crtc_shadow.regs, sizeof(anchor->regs));
+    __atomic_store_n(&anchor->seq, anchor->seq + 1, __ATOMIC_RELEASE);
+}
 
-    // Graphics mode: Fill with test pattern
-    for (int i = 0; i < GRAPHICS_BUFFER_SIZE; i++) {
-        graphics_buffer[i] = i & 0xFF; // Simple pattern
+static void __not_in_flash_func(start_raster)(void) {
+    hal_raster_start(raster_timeline, raster.words);
+    raster.built = false;
+    raster.starting = true;
+}
+
+// Once a set is out, new timings stop the engine and the timeline is rebuilt one line per
+// pass (a frame is a few hundred passes, well inside the blank). Rows of a single scanline
+// have no RA0 edge to start from; 3DAh stays on the anchor then, as it does when the
+// frame needs more than RASTER_TIMELINE_WORDS runs.
+__always_inline static void service_raster(void) {
+    // Past line 0 the engine has its edge and its byte is current
+    if (raster.starting && hal_gpio_get_all() >> PIN_RA_BASE & ((1u << RA_WIDTH) - 1)) {
+        raster.starting = false;
+        __atomic_store_n(&raster.live, true, __ATOMIC_RELEASE);
+    }
+    if (flushing) {
+        return;
+    }
+    if (!cga_io_same_timings(raster.regs, crtc_shadow.regs)) {
+        if (raster.live || raster.starting) {
+            __atomic_store_n(&raster.live, false, __ATOMIC_RELEASE);
+            raster.starting = false;
+            hal_raster_stop();
+        }
+        memcpy(raster.regs, crtc_shadow.regs, sizeof(raster.regs));
+        raster.line = 1;
+        raster.words = 0;
+        raster.built = false;
+        raster.building = (raster.regs[9] & 0x1F) != 0;
+        return;
+    }
+    if (!raster.building) {
+        return;
+    }
+    const uint32_t lines = cga_io_frame_lines(raster.regs);
+    raster.words =
+        cga_io_timeline_line(raster.regs, raster.line % lines, raster_timeline, raster.words, RASTER_TIMELINE_WORDS);
+    if (!raster.words) {
+        raster.building = false;
+    } else if (raster.line++ == lines) {
+        raster.building = false;
+        raster.built = true;
     }
 }
 
-// MC6845 register values for CGA 40x25 Text Mode
-static const uint8_t mc6845_cga_40x25[16] = {
-    0x38, // R0: Horizontal Total (56)
-    0x28, // R1: Horizontal Displayed (40)
-    0x2D, // R2: HSync Position (45)
-    0x0A, // R3: HSync Width (10)
-    0x1F, // R4: Vertical Total (31)
-    0x06, // R5: VTotal Adjust (6)
-    0x19, // R6: Vertical Displayed (25)
-    0x1C, // R7: VSync Position (28)
-    0x02, // R8: Interlace Mode (Non-interlaced)
-    0x07, // R9: Max Scanline Address (7, for 8 lines per char)
-    0x00, // R10: Cursor Start Line (6)
-    0x07, // R11: Cursor End Line (7)
-    0x00, // R12: Start Addr (H)
-    0x00, // R13: Start Addr (L)
-    0x00, // R14: Cursor Addr (H)
-    0x00 // R15: Cursor Addr (L)
-};
-
-// MC6845 register values for CGA 80x25 Text Mode
-static const uint8_t mc6845_cga_80x25[16] = {
-    0x71, // R0: Horizontal Total (113)
-    0x50, // R1: Horizontal Displayed (80)
-    0x5A, // R2: HSync Position (90)
-    0x0A, // R3: HSync Width (10)
-    0x1F, // R4: Vertical Total (31)
-    0x06, // R5: VTotal Adjust (6)
-    0x19, // R6: Vertical Displayed (25)
-    0x1C, // R7: VSync Position (28)
-    0x02, // R8: Interlace Mode (Non-interlaced)
-    0x07, // R9: Max Scanline Address (7, for 8 lines per char)
-    0x00, // R10: Cursor Start Line (6)
-    0x07, // R11: Cursor End Line (7)
-    0x00, // R12: Start Addr (H)
-    0x00, // R13: Start Addr (L)
-    0x00, // R14: Cursor Addr (H)
-    0x00 // R15: Cursor Addr (L)
-};
-
-// MC6845 register values for CGA 320x200 4-Color Graphics Mode
-// MC6845 register values for CGA 640x200 2-Color Graphics Mode
-// Note: Timing parameters are identical to 320x200 mode.
-// The higher resolution is handled by the CGA's internal logic,
-// selected via the Mode Control Register.
-static const uint8_t mc6845_cga_320x200[16] = {
-    0x38, // R0: Horizontal Total (56)
-    0x28, // R1: Horizontal Displayed (40)
-    0x2D, // R2: HSync Position (45)
-    0x0A, // R3: HSync Width (10)
-    0x7F, // R4: Vertical Total (127)
-    0x06, // R5: VTotal Adjust (6)
-    0x64, // R6: Vertical Displayed (100)
-    0x70, // R7: VSync Position (112)
-    0x02, // R8: Interlace Mode (Non-interlaced)
-    0x01, // R9: Max Scanline Address (1, for 2 lines per "char row")
-    0x00, // R10: Cursor Start (Cursor typically disabled)
-    0x00, // R11: Cursor End (Cursor typically disabled)
-    0x00, // R12: Start Addr (H)
-    0x00, // R13: Start Addr (L)
-    0x00, // R14: Cursor Addr (H)
-    0x00 // R15: Cursor Addr (L)
-};
+// Vertical retrace events: the MA lines are checked against the shadow registers on
+// every pass. Entering the blank counts a frame and starts sending whatever has been
+// committed: page flip, fetch mode and DOTCLK first, then only the registers that differ
+// from the shadow, as fast as the write engine takes them (16 writes take 32 us of a
+// ~4 ms blank).
+static void __not_in_flash_func(service_vblank)(void) {
+    if (!flushing) {
+        const uint32_t pins = hal_gpio_get_all();
+#if CGA_ISA_VRAM
+        // MA0..MA13 carry the ISA address while a CPU cycle is on the window
+        if (!(pins & 1u << PIN_ISA_VRAMOE) || !(pins & 1u << PIN_ISA_VRAMWR)) return;
+#endif
+        const uint32_t ma = pins >> PIN_MA_BASE & ((1u << MA_WIDTH) - 1);
+        const ma_region_t region = crtc_shadow_in_vblank(&crtc_shadow, ma)      ? MA_BLANK
+                                   : crtc_shadow_in_first_row(&crtc_shadow, ma) ? MA_FIRST_ROW
+                                                                                : MA_DISPLAY;
+        const uint64_t now = hal_time_us();
+        if (region != ma_region) {
+            ma_region = region;
+            ma_region_since = now;
+            ma_region_pins = UINT32_MAX;
+        }
+        if (region == MA_DISPLAY || now - ma_region_since < MA_SETTLE_US) {
+            return;
+        }
+        if (region == MA_FIRST_ROW) {
+            // The anchor wants the position itself: two reads in a row that agree
+            if (!frame_armed && pins == ma_region_pins) {
+                anchor_raster(pins, ma);
+                // Line 0: the engine starts on the RA0 edge that ends it
+                if (raster.built && !(pins >> PIN_RA_BASE & ((1u << RA_WIDTH) - 1))) start_raster();
+                frame_armed = true;
+                blank_open = false;
+            }
+            ma_region_pins = pins;
+            return;
+        }
+        if (frame_armed) {
+            frame_armed = false;
+            blank_open = true;
+            __atomic_store_n(&video_frames, video_frames + 1, __ATOMIC_RELEASE);
+        }
+        // One set per blank: after new timings the rest of the frame is out of step with
+        // the shadow and the blank test cannot be trusted until row 0 comes round again
+        if (!blank_open ||
+            (!crtc_shadow.dirty && committed_fetch_mode == fetch_mode && committed_page == fetch_page)) {
+            return;
+        }
+        blank_open = false;
+        flushing = true;
+        if (committed_fetch_mode != fetch_mode || committed_page != fetch_page) {
+            fetch_mode = committed_fetch_mode;
+            __atomic_store_n(&fetch_page, committed_page, __ATOMIC_RELEASE);
+            apply_fetch_mode();
+        }
+    }
+    while (hal_crtc_write_ready()) {
+        const int reg = crtc_shadow_next(&crtc_shadow);
+        if (reg < 0) {
+            flushing = false;
+            return;
+        }
+        mc6845_write_register(reg, crtc_shadow.regs[reg]);
+    }
+}
 
-// ==========================================================
-// Low-level helpers
-// ==========================================================
+uint32_t cga_video_frames(void) {
+    return __atomic_load_n(&video_frames, __ATOMIC_ACQUIRE);
+}
 
-static void data_bus_set_output(void) {
-    const uint32_t mask = 0xFF << PIN_DATA_BASE;
-    gpio_set_dir_masked(mask, mask);
+uint8_t cga_video_page(void) {
+    return __atomic_load_n(&fetch_page, __ATOMIC_ACQUIRE);
 }
 
-// Вывод данных на шину данных MC6845 (используется для регистров и видеоданных)
-__always_inline static void data_bus_write(const uint8_t value) {
-    const uint32_t mask = 0xFF << PIN_DATA_BASE;
-    gpio_put_masked(mask, (uint32_t) value << PIN_DATA_BASE);
+uint8_t cga_io_read(const uint16_t port) {
+    if (port != CGA_IO_STATUS) {
+        return 0xFF; // Nothing else in the block drives the bus on a read
+    }
+    if (__atomic_load_n(&raster.live, __ATOMIC_ACQUIRE)) {
+        return hal_raster_status();
+    }
+    raster_anchor_t anchor;
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&raster_anchor.seq, __ATOMIC_ACQUIRE);
+        anchor = raster_anchor;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&raster_anchor.seq, __ATOMIC_RELAXED));
+    if (!seq) {
+        return CGA_STATUS_IDLE; // No frame seen yet
+    }
+    const uint64_t chars = anchor.chars + ((hal_time_us() - anchor.us) * anchor.rate >> 16);
+    return cga_io_status(anchor.regs, (uint32_t) chars);
 }
 
-__always_inline static uint8_t data_bus_read() {
-    const uint32_t mask = 0xFF << PIN_DATA_BASE;
-    return (uint8_t) ((gpio_get_all() & mask) >> PIN_DATA_BASE);
+// One pass: drain the captured fetches and CPU writes, check for the blank, build a line
+// of the 3DAh timeline, then stage at most one mailbox message. Nothing is taken while a
+// set is going out, so a commit never lands in the middle of one.
+void __not_in_flash_func(cga_video_poll)(void) {
+    service_video_fetches();
+    service_isa_writes();
+    hal_crtc_write_poll();
+    service_vblank();
+    service_raster();
+
+    uint32_t message;
+    if (!flushing && core_mailbox_try_take(&mailbox, &message)) {
+        switch (message >> 16) {
+            case CORE_MAILBOX_CRTC_WRITE:
+                crtc_shadow_stage(&crtc_shadow, message >> 8 & 0x1F, message & 0xFF);
+                break;
+            case CORE_MAILBOX_FETCH_MODE:
+                staged_fetch_mode = (video_mode_t) (message & 0xFF);
+                break;
+            case CORE_MAILBOX_PAGE:
+                staged_page = message & (VIDEO_PAGES - 1);
+                break;
+            case CORE_MAILBOX_COMMIT:
+                crtc_shadow_commit(&crtc_shadow);
+                committed_fetch_mode = staged_fetch_mode;
+                committed_page = staged_page;
+                break;
+        }
+    }
 }
 
-// Active edge high→low on E
-__always_inline static void pulse_enable(void) {
-    gpio_put(PIN_MC6845_E, 1);
-    sleep_us(1);
-    gpio_put(PIN_MC6845_E, 0);
-    sleep_us(1);
+static void __not_in_flash_func(video_core_main)(void) {
+    // Nothing on core 1 needs an interrupt, and none may delay a fetch
+    hal_interrupts_disable();
+    while (true) {
+        cga_video_poll();
+    }
 }
 
 // ==========================================================
-// Register access
+// Core 0: console
 // ==========================================================
 
-static void mc6845_write_register(const uint8_t reg, const uint8_t value) {
-    data_bus_set_output();
-    gpio_put(PIN_MC6845_CS, 0);
-    gpio_put(PIN_MC6845_RW, 0);
+// Mailbox room a mode switch needs: fetch mode + R0..R15 + commit
+#define MODE_SWITCH_MESSAGES 18
+
+// Per-frame updates, each a register pair and a commit; core 1 applies the latest one in the blank
+static uint16_t cursor_pos = 0;
+static uint16_t start_address = 0;
+static uint32_t cursor_frame = 0;
+static uint8_t pattern_phase = 0;
+static bool flip_in_flight = false;
+
+// Console input: keys and upload packets share the USB CDC stream (upload_protocol.h)
+static upload_parser_t upload;
+static uint8_t upload_seq = 0; // Sequence number expected next
+static uint8_t console_rx[512];
+static uint32_t console_rx_len = 0, console_rx_pos = 0;
+
+static void post(const uint8_t opcode, const uint8_t reg, const uint8_t value) {
+    // Callers check core_mailbox_free() first, core 0 never waits on core 1
+    core_mailbox_try_post(&mailbox, core_mailbox_message(opcode, reg, value));
+}
 
-    gpio_put(PIN_MC6845_RS, 0);
-    data_bus_write(reg & 0x1F);
-    pulse_enable();
+static void print_mode(const video_mode_t mode) {
+    const video_mode_desc_t *desc = video_mode_desc(mode);
+    printf("%s @ %.5f MHz", desc->name, desc->dotclk_hz / MHZ);
+}
 
-    gpio_put(PIN_MC6845_RS, 1);
-    data_bus_write(value);
-    pulse_enable();
+// The descriptor's whole table is posted; core 1 only writes what differs from the chip,
+// and activates the rest of the descriptor with the registers in the same vertical blank.
+static void switch_mode(const video_mode_t mode) {
+    const uint8_t *regs = video_mode_desc(mode)->crtc;
+    current_video_mode = mode;
+    post(CORE_MAILBOX_FETCH_MODE, 0, mode);
+    for (int r = 0; r < 16; r++) {
+        post(CORE_MAILBOX_CRTC_WRITE, r, regs[r]);
+    }
+    post(CORE_MAILBOX_COMMIT, 0, 0);
+    start_address = 0;
+}
 
-    gpio_put(PIN_MC6845_CS, 1);
+// R12/R13 or R14/R15: high byte, low byte, commit
+static void post_address(const uint8_t reg_high, const uint16_t address) {
+    post(CORE_MAILBOX_CRTC_WRITE, reg_high, address >> 8 & 0x3F);
+    post(CORE_MAILBOX_CRTC_WRITE, reg_high + 1, address & 0xFF);
+    post(CORE_MAILBOX_COMMIT, 0, 0);
+}
+
+// Show the back page from the next blank on. Core 0 keeps off both pages until
+// cga_video_page() confirms it, then draws into the old front page. Whatever a delta
+// frame left out is completed from the front page first.
+static void flip(void) {
+    video_delta_finish();
+    post(CORE_MAILBOX_PAGE, 0, video_back_page);
+    post(CORE_MAILBOX_COMMIT, 0, 0);
+    flip_in_flight = true;
 }
 
 // ==========================================================
-// Initialization
+// Core 0: 3Dxh registers (cga_io.h)
 // ==========================================================
 
-static void init_all_gpio(void) {
-    // MC6845 control pins
-    for (int i = 0; i < 4; i++) {
-        const uint8_t mc6845_pins[] = {PIN_MC6845_CS, PIN_MC6845_RS, PIN_MC6845_E, PIN_MC6845_RW};
-        gpio_init(mc6845_pins[i]);
-        gpio_set_dir(mc6845_pins[i], GPIO_OUT);
+static uint8_t io_crtc_index = 0;
+static bool io_crtc_staged = false; // 3D5h writes posted, commit outstanding
+
+// An OUT to the 3Dxh block. Callers check for MODE_SWITCH_MESSAGES of mailbox room;
+// 3D5h writes are staged until io_flush(). A 3D8h mode change loads the mode's
+// table, so a program that goes on to write its own through 3D5h still gets them.
+// R9 written in 80x25 or 160x100 can switch between the two (cga_io_tweak_mode()); the
+// fetch mode goes out with the staged writes. 3D9h is held by the latch on the board alone.
+static void io_write(const uint16_t port, const uint8_t value) {
+    video_mode_t mode;
+    switch (port) {
+        case CGA_IO_CRTC_INDEX:
+            io_crtc_index = value & 0x1F;
+            break;
+        case CGA_IO_CRTC_DATA:
+            if (io_crtc_index < 16) {
+                post(CORE_MAILBOX_CRTC_WRITE, io_crtc_index, value);
+                io_crtc_staged = true;
+                if (io_crtc_index == 9 && cga_io_tweak_mode(current_video_mode, value, &mode)) {
+                    current_video_mode = mode;
+                    post(CORE_MAILBOX_FETCH_MODE, 0, mode);
+                    print_mode(mode);
+                    printf(" (R9 = %u)\n", value);
+                }
+            }
+            break;
+        case CGA_IO_MODE:
+            mode = cga_io_video_mode(value);
+            if (mode != current_video_mode) {
+                switch_mode(mode); // Commits whatever was staged too
+                io_crtc_staged = false;
+                print_mode(mode);
+                printf(" (3D8h = %02Xh)\n", value);
+            }
+            break;
+        default:
+            break;
     }
-    gpio_put(PIN_MC6845_CS, 1);
-    gpio_put(PIN_MC6845_E, 0);
+}
 
-    // Data bus + Address monitoring
-    for (int i = 0; i < 25; i++) {
-        gpio_init(i);
-        gpio_set_dir(i, i < 17 ? GPIO_IN : GPIO_OUT);
+static void io_flush(void) {
+    if (io_crtc_staged) {
+        post(CORE_MAILBOX_COMMIT, 0, 0);
+        io_crtc_staged = false;
     }
+}
 
-    init_clock_pio(pio0, SM_CLOCK, PIN_MC6845_CLK, current_clock_freq);
-
-    // Setup MC6845 registers
-    for (int r = 0; r < 16; r++) {
-        mc6845_write_register(r, mc6845_cga_80x25[r]);
+// An UPLOAD_PORT payload has to go out whole within MODE_SWITCH_MESSAGES of mailbox
+// room; false on an odd length or a port outside the block
+static bool io_packet_fits(const uint8_t *payload, const uint32_t length) {
+    if (length & 1) {
+        return false;
     }
+    video_mode_t mode = current_video_mode, next;
+    uint8_t index = io_crtc_index;
+    uint32_t messages = 0, crtc_writes = 0; // crtc_writes: staged messages, fetch modes included
+    for (uint32_t i = 0; i < length; i += 2) {
+        switch (0x300 | payload[i]) {
+            case CGA_IO_CRTC_INDEX:
+                index = payload[i + 1] & 0x1F;
+                break;
+            case CGA_IO_COLOR:
+                break;
+            case CGA_IO_CRTC_DATA:
+                crtc_writes++;
+                if (index == 9 && cga_io_tweak_mode(mode, payload[i + 1], &next)) {
+                    crtc_writes++;
+                    mode = next;
+                }
+                break;
+            case CGA_IO_MODE:
+                next = cga_io_video_mode(payload[i + 1]);
+                if (next != mode) {
+                    messages += MODE_SWITCH_MESSAGES;
+                    mode = next;
+                }
+                break;
+            default:
+                return false;
+        }
+    }
+    return messages + crtc_writes + (crtc_writes != 0) <= MODE_SWITCH_MESSAGES;
 }
 
+// A key's mode goes out as its descriptor's 3D8h value, as a program would write it
+static void key_mode(const video_mode_t mode) {
+    io_write(CGA_IO_MODE, video_mode_desc(mode)->mode_control);
+}
 
-static void process_video_address(const uint16_t address, const uint8_t row) {
-    if (current_video_mode == VIDEO_MODE_GRAPHICS) {
-        data_bus_write(graphics_buffer[address]);
-    } else {
-        // Текстовые режимы (80x25 и 40x25)
-        data_bus_write(cga_font_8x8[text_buffer[address] * 8 + row]);
+static void handle_key(const int c) {
+    if (c == 't') {
+        // 80x25 <-> 40x25 (from graphics: 80x25), BIOS modes 3 and 1
+        key_mode(current_video_mode == VIDEO_MODE_TEXT_80x25 ? VIDEO_MODE_TEXT_40x25 : VIDEO_MODE_TEXT_80x25);
+    } else if (c == 'g') {
+        key_mode(VIDEO_MODE_GRAPHICS); // BIOS mode 4
+    } else if (c == 'h') {
+        key_mode(VIDEO_MODE_GRAPHICS_640); // BIOS mode 6
+    } else if (c == 'w') {
+        // 160x100 has no 3D8h value of its own: the whole table, as for the other keys' modes
+        if (current_video_mode != VIDEO_MODE_TEXT_160x100) {
+            switch_mode(VIDEO_MODE_TEXT_160x100);
+            print_mode(VIDEO_MODE_TEXT_160x100);
+            printf("\n");
+        }
+    } else if (c == 'r') {
+        init_test_patterns(++pattern_phase);
+        flip();
+    } else if (c == 's') {
+        start_address = (start_address + video_mode_desc(current_video_mode)->crtc[1]) & 0x3FFF;
+        post_address(12, start_address);
     }
 }
 
+static void upload_send_reply(const uint8_t status, const uint8_t seq) {
+    uint8_t reply[UPLOAD_REPLY_SIZE];
+    upload_reply(reply, status, seq);
+    hal_console_write(reply, sizeof(reply));
+}
 
-void main() {
-    // Configure RP2040 system clock
-    hw_set_bits(&vreg_and_chip_reset_hw->vreg, VREG_AND_CHIP_RESET_VREG_VSEL_BITS);
-    set_sys_clock_hz(SYSTEM_CLOCK_HZ, true);
-    busy_wait_ms(25);
+// Apply a packet with a good CRC to the back page, in sequence order
+static void handle_packet(const upload_parser_t *packet) {
+    if (packet->type == UPLOAD_SYNC) {
+        upload_seq = packet->seq + 1;
+        upload_send_reply(UPLOAD_ACK, packet->seq);
+        return;
+    }
+    if (packet->seq == (uint8_t) (upload_seq - 1)) {
+        // Resent after a lost ACK, already applied
+        upload_send_reply(UPLOAD_ACK, packet->seq);
+        return;
+    }
+    if (packet->seq != upload_seq) {
+        upload_send_reply(UPLOAD_NAK, upload_seq);
+        return;
+    }
+    upload_seq++;
+
+    const uint32_t end = packet->offset + packet->length;
+    bool applied = true;
+    switch (packet->type) {
+        case UPLOAD_TEXT:
+            applied = end <= TEXT_WINDOW_BYTES;
+            if (applied) video_text_write(packet->offset, packet->payload, packet->length);
+            break;
+        case UPLOAD_GRAPHICS:
+            applied = end <= GRAPHICS_WINDOW_BYTES;
+            if (applied) video_graphics_write(packet->offset, packet->payload, packet->length);
+            break;
+        case UPLOAD_TEXT_DELTA:
+            applied = video_text_delta(packet->offset, packet->payload, packet->length);
+            break;
+        case UPLOAD_GRAPHICS_DELTA:
+            applied = video_graphics_delta(packet->offset, packet->payload, packet->length);
+            break;
+        case UPLOAD_FONT:
+            applied = end <= sizeof(font_slots);
+            if (applied) video_font_write(packet->offset, packet->payload, packet->length);
+            break;
+        case UPLOAD_FONT_SELECT:
+            applied = packet->length == 1 && packet->offset < FONT_SLOTS &&
+                      video_font_select(packet->offset, packet->payload[0]);
+            break;
+        case UPLOAD_FLIP:
+            flip();
+            break;
+        case UPLOAD_PORT:
+            applied = io_packet_fits(packet->payload, packet->length);
+            if (applied) {
+                for (uint32_t i = 0; i < packet->length; i += 2) {
+                    io_write(0x300 | packet->payload[i], packet->payload[i + 1]);
+                }
+                io_flush();
+            }
+            break;
+        default:
+            applied = false;
+            break;
+    }
+    upload_send_reply(applied ? UPLOAD_ACK : UPLOAD_REJECT, packet->seq);
+}
+
+// One USB read per poll, parsed up to the point where core 0 has to wait: input stays
+// buffered while a flip is in flight (the next packet may target the page about to be
+// shown) or the mailbox has no room for a mode switch. USB flow control then holds
+// the host back.
+static void service_console(void) {
+    if (console_rx_pos == console_rx_len && !flip_in_flight) {
+        console_rx_len = hal_console_read(console_rx, sizeof(console_rx));
+        console_rx_pos = 0;
+    }
+    while (console_rx_pos < console_rx_len && !flip_in_flight &&
+           core_mailbox_free(&mailbox) >= MODE_SWITCH_MESSAGES) {
+        upload_event_t event;
+        console_rx_pos += upload_parse(&upload, &console_rx[console_rx_pos], console_rx_len - console_rx_pos, &event);
+        if (event == UPLOAD_EVENT_KEY) {
+            handle_key(upload.key);
+        } else if (event == UPLOAD_EVENT_PACKET) {
+            handle_packet(&upload);
+        } else if (event == UPLOAD_EVENT_BAD) {
+            upload_send_reply(UPLOAD_NAK, upload_seq);
+        }
+    }
+}
 
-    stdio_usb_init();
-    busy_wait_ms(1000);
+void cga_setup(void) {
+    hal_system_init(SYSTEM_CLOCK_HZ);
 
-    printf("CGA Video Emulator\nCommands: t/g/r\n");
-    printf("t = toggle text mode (80x25 <-> 40x25)\n");
-    printf("g = switch to graphics mode (320x200)\n");
-    printf("r = regenerate test patterns\n");
+    printf("CGA Video Emulator\nCommands: t/g/h/w/r/s\n");
+    printf("t = toggle text mode (80x25 <-> 40x25), as an OUT to 3D8h\n");
+    printf("g = switch to graphics mode (320x200), as an OUT to 3D8h\n");
+    printf("h = switch to graphics mode (640x200), as an OUT to 3D8h\n");
+    printf("w = switch to tweaked text mode (160x100, 80x25 with R9 = 1)\n");
+    printf("r = regenerate test patterns (drawn off-screen, shown with a page flip)\n");
+    printf("s = scroll the start address by one row\n");
+    printf("Binary uploads on the same port, see upload_protocol.h\n");
 
     init_all_gpio();
-    init_test_patterns();
+    video_memory_init();
+    upload_parser_init(&upload);
+    hal_core1_launch(video_core_main);
+}
 
-    uint32_t prev_addr = 0xFFFFFFFF;
+void cga_poll(void) {
+    // A flip has landed once the back page is on screen: draw into the other one from now on
+    if (flip_in_flight && cga_video_page() == video_back_page) {
+        video_back_page ^= 1;
+        flip_in_flight = false;
+        video_font_follow();
+    }
 
-    uint16_t i = 0;
-    while (1) {
-        const uint32_t addr = gpio_get_all() & 0x1FFFF;
+    service_console();
 
-        if (addr != prev_addr) {
-            prev_addr = addr;
-            process_video_address(addr & 0x3FFF, addr >> 14);
-        }
+#if CGA_ISA_VRAM
+    // 3Dxh writes from the ISA bus, each its own set
+    uint32_t message;
+    while (core_mailbox_free(&mailbox) >= MODE_SWITCH_MESSAGES && core_mailbox_try_take(&io_mailbox, &message)) {
+        io_write(0x3D0 | (message >> 8 & 0xF), message & 0xFF);
+        io_flush();
+    }
+#endif
+
+    // Cursor walk, one step per frame; skipped for a frame if core 1 is behind
+    const uint32_t frame = cga_video_frames();
+    if (frame != cursor_frame && core_mailbox_free(&mailbox) >= 3) {
+        cursor_frame = frame;
+        cursor_pos++;
+        cursor_pos %= (80 * 25);
+        post_address(14, cursor_pos);
+    }
+}
 
-        int c = getchar_timeout_us(0);
-        if (c == 't') {
-            // Переключение между текстовыми режимами
-            if (current_video_mode == VIDEO_MODE_TEXT_80x25) {
-                // Переход на 40x25
-                current_video_mode = VIDEO_MODE_TEXT_40x25;
-                current_clock_freq = CLOCK_FREQ_GRAPHICS;
-                change_clock_frequency(pio0, SM_CLOCK, current_clock_freq);
-                for (int r = 0; r < 16; r++) {
-                    mc6845_write_register(r, mc6845_cga_40x25[r]);
-                }
-                printf("Text mode 40x25 @ 7.15909 MHz\n");
-            } else {
-                // Переход на 80x25 (из любого другого режима)
-                current_video_mode = VIDEO_MODE_TEXT_80x25;
-                current_clock_freq = CLOCK_FREQ_TEXT;
-                change_clock_frequency(pio0, SM_CLOCK, current_clock_freq);
-                for (int r = 0; r < 16; r++) {
-                    mc6845_write_register(r, mc6845_cga_80x25[r]);
-                }
-                printf("Text mode 80x25 @ 14.31818 MHz\n");
-            }
-        } else if (c == 'g') {
-            // Переключение в графический режим
-            current_video_mode = VIDEO_MODE_GRAPHICS;
-            current_clock_freq = CLOCK_FREQ_GRAPHICS;
-            change_clock_frequency(pio0, SM_CLOCK, current_clock_freq);
-            for (int r = 0; r < 16; r++) {
-                mc6845_write_register(r, mc6845_cga_320x200[r]);
-            }
-            printf("Graphics mode 320x200 @ 7.15909 MHz\n");
-        } else if (c == 'r') init_test_patterns();
-        i++;
-        i %= (80 * 25);
-        mc6845_write_register(15, i & 0xff);
-        mc6845_write_register(14, i >> 8);
-        busy_wait_ms(10);
+#if !CGA_HOST
+void main() {
+    cga_setup();
+    while (1) {
+        cga_poll();
     }
 }
+#endif
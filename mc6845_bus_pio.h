@@ -0,0 +1,75 @@
+// Written by hand around pioasm output; nothing regenerates it. mc6845_bus.pio is the
+// source of truth for the program: the instruction table, wrap and default config below
+// must match what pioasm makes of it. The bus clock, cycle count and init are ours.
+
+#pragma once
+
+#if !PICO_NO_HARDWARE
+#include "hardware/pio.h"
+#include <hardware/clocks.h>
+#endif
+
+#define PIO_CRTC pio1
+#define SM_CRTC 1
+
+// Engine clock and the cost of one register write in its cycles
+#define MC6845_BUS_HZ (8 * MHZ)
+#define MC6845_BUS_WRITE_CYCLES 16
+
+// ---------- //
+// mc6845_bus //
+// ---------- //
+
+#define mc6845_bus_wrap_target 0
+#define mc6845_bus_wrap 6
+
+static const uint16_t mc6845_bus_program_instructions[] = {
+            //     .wrap_target
+    0x84a0, //  0: pull   block           side 1
+    0x6108, //  1: out    pins, 8         side 0 [1]
+    0xb342, //  2: nop                    side 4 [3]
+    0xa142, //  3: nop                    side 0 [1]
+    0x6908, //  4: out    pins, 8         side 2 [1]
+    0xbb42, //  5: nop                    side 6 [3]
+    0xa842, //  6: nop                    side 2
+            //     .wrap
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program mc6845_bus_program = {
+    .instructions = mc6845_bus_program_instructions,
+    .length = 7,
+    .origin = -1,
+};
+
+static inline pio_sm_config mc6845_bus_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + mc6845_bus_wrap_target, offset + mc6845_bus_wrap);
+    sm_config_set_sideset(&c, 3, false, false);
+    return c;
+}
+
+// CS/RS/E go to PIO1 for good; D0..D7 only get their pin directions here, the
+// function select stays with the video engine until a write burst claims them
+static inline void mc6845_bus_program_init(PIO pio, uint sm, uint offset, uint ctrl_pin_base, uint data_pin_base) {
+    pio_sm_config c = mc6845_bus_program_get_default_config(offset);
+    sm_config_set_out_pins(&c, data_pin_base, 8);
+    sm_config_set_sideset_pins(&c, ctrl_pin_base);
+    sm_config_set_out_shift(&c, true, false, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&c, (float) clock_get_hz(clk_sys) / MC6845_BUS_HZ);
+    // Idle levels before the pins switch over: CS high, E low
+    pio_sm_set_pins_with_mask(pio, sm, 1u << ctrl_pin_base, 7u << ctrl_pin_base);
+    pio_sm_set_consecutive_pindirs(pio, sm, ctrl_pin_base, 3, true);
+    pio_sm_set_consecutive_pindirs(pio, sm, data_pin_base, 8, true);
+    for (uint pin = ctrl_pin_base; pin < ctrl_pin_base + 3; pin++) {
+        pio_gpio_init(pio, pin);
+    }
+    pio_sm_init(pio, sm, offset, &c);
+    pio_sm_set_enabled(pio, sm, true);
+}
+#endif
+
+static inline void init_mc6845_bus_pio(PIO pio, uint sm, uint ctrl_pin_base, uint data_pin_base) {
+    mc6845_bus_program_init(pio, sm, pio_add_program(pio, &mc6845_bus_program), ctrl_pin_base, data_pin_base);
+}
@@ -0,0 +1,135 @@
+#include "mc6845_model.h"
+
+#include <string.h>
+
+// Writable bits of R0-R15 on the MC6845
+static const uint8_t register_mask[16] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0x7F, 0x1F, 0x7F, 0x7F,
+    0x03, 0x1F, 0x7F, 0x1F, 0x3F, 0xFF, 0x3F, 0xFF,
+};
+
+static inline uint16_t start_address(const mc6845_model_t *crtc) {
+    return (uint16_t) (crtc->regs[12] << 8 | crtc->regs[13]);
+}
+
+static inline uint16_t cursor_address(const mc6845_model_t *crtc) {
+    return (uint16_t) (crtc->regs[14] << 8 | crtc->regs[15]);
+}
+
+static bool cursor_visible(const mc6845_model_t *crtc) {
+    switch (crtc->regs[10] >> 5 & 3) {
+        case 0: return true;                         // Steady
+        case 1: return false;                        // Cursor off
+        case 2: return !(crtc->frame >> 3 & 1);      // Blink, 1/16 field rate
+        default: return !(crtc->frame >> 4 & 1);     // Blink, 1/32 field rate
+    }
+}
+
+static void begin_row(mc6845_model_t *crtc) {
+    if (crtc->row == crtc->regs[7]) {
+        crtc->vsync_count = MC6845_VSYNC_LINES;
+    }
+}
+
+static void begin_frame(mc6845_model_t *crtc) {
+    crtc->row = 0;
+    crtc->ra = 0;
+    crtc->in_adjust = false;
+    crtc->ma_row = start_address(crtc);
+    begin_row(crtc);
+}
+
+static void end_of_line(mc6845_model_t *crtc) {
+    const uint8_t *r = crtc->regs;
+
+    if (crtc->vsync_count) {
+        crtc->vsync_count--;
+    }
+
+    if (crtc->in_adjust) {
+        if (++crtc->ra >= r[5]) {
+            crtc->frame++;
+            begin_frame(crtc);
+        }
+        return;
+    }
+
+    if (crtc->ra != r[9]) {
+        crtc->ra = (crtc->ra + 1) & 0x1F;
+        return;
+    }
+
+    // Last scanline of the character row
+    crtc->ra = 0;
+    crtc->ma_row = (crtc->ma_row + r[1]) & 0x3FFF;
+    if (crtc->row == r[4]) {
+        if (r[5]) {
+            crtc->in_adjust = true;
+        } else {
+            crtc->frame++;
+            begin_frame(crtc);
+        }
+        return;
+    }
+    crtc->row = (crtc->row + 1) & 0x7F;
+    begin_row(crtc);
+}
+
+void mc6845_model_init(mc6845_model_t *crtc, const uint8_t regs[16]) {
+    memset(crtc, 0, sizeof(*crtc));
+    for (int r = 0; r < 16; r++) {
+        mc6845_model_write(crtc, r, regs[r]);
+    }
+    begin_frame(crtc);
+    if (crtc->regs[2] == 0) {
+        crtc->hsync_count = crtc->regs[3] & 0x0F;
+    }
+}
+
+void mc6845_model_write(mc6845_model_t *crtc, const uint8_t reg, const uint8_t value) {
+    if (reg < 16) {
+        crtc->regs[reg] = value & register_mask[reg];
+    }
+}
+
+void mc6845_model_bus_write(mc6845_model_t *crtc, const bool rs, const uint8_t value) {
+    if (rs) {
+        mc6845_model_write(crtc, crtc->address, value);
+    } else {
+        crtc->address = value & 0x1F;
+    }
+}
+
+void mc6845_model_clock(mc6845_model_t *crtc, mc6845_outputs_t *out) {
+    const uint8_t *r = crtc->regs;
+    const uint16_t ma = (crtc->ma_row + crtc->hcount) & 0x3FFF;
+    const bool de = crtc->hcount < r[1] && crtc->row < r[6] && !crtc->in_adjust;
+
+    out->ma = ma;
+    out->ra = crtc->ra;
+    out->de = de;
+    out->hsync = crtc->hsync_count != 0;
+    out->vsync = crtc->vsync_count != 0;
+    out->cursor = de && ma == cursor_address(crtc) &&
+                  crtc->ra >= (r[10] & 0x1F) && crtc->ra <= r[11] && cursor_visible(crtc);
+
+    // Advance to the next character
+    crtc->clocks++;
+    if (crtc->hsync_count) {
+        crtc->hsync_count--;
+    }
+    if (crtc->hcount == r[0]) {
+        crtc->hcount = 0;
+        end_of_line(crtc);
+    } else {
+        crtc->hcount++;
+    }
+    if (crtc->hcount == r[2]) {
+        crtc->hsync_count = r[3] & 0x0F;
+    }
+}
+
+uint32_t mc6845_model_frame_clocks(const uint8_t regs[16]) {
+    const uint32_t scanlines = (uint32_t) ((regs[4] & 0x7F) + 1) * ((regs[9] & 0x1F) + 1) + (regs[5] & 0x1F);
+    return (uint32_t) (regs[0] + 1) * scanlines;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// MC6845 CRTC model, one step per character clock.
+// Pure C with no SDK dependencies: it is fed the same R0-R15 tables the firmware
+// programs into the real chip and produces the MA/RA/DE/HSYNC/VSYNC/CURSOR
+// sequence the RP2040 sees on GPIO0..16, so the fetch path can be replayed on a PC.
+// https://cpctech.cpcwiki.de/docs/mc6845/mc6845.htm
+//
+// Modelled as the Motorola part: HSYNC width 0 means no HSYNC, VSYNC is fixed
+// at 16 scanlines, interlace (R8) is ignored, light pen registers are not implemented.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MC6845_VSYNC_LINES 16
+
+typedef struct {
+    uint16_t ma; // MA0..MA13
+    uint8_t ra;  // RA0..RA4
+    bool de;     // Display Enable
+    bool hsync;
+    bool vsync;
+    bool cursor;
+} mc6845_outputs_t;
+
+typedef struct {
+    uint8_t regs[16];
+    uint8_t address; // Address register (selected with RS=0)
+
+    uint8_t hcount;      // Horizontal character counter, 0..R0
+    uint8_t row;         // Character row counter, 0..R4
+    uint8_t ra;          // Scanline counter, 0..R9 (0..R5-1 during adjust)
+    uint8_t hsync_count; // Characters of HSYNC left
+    uint8_t vsync_count; // Scanlines of VSYNC left
+    bool in_adjust;      // Inside the R5 vertical total adjust lines
+    uint16_t ma_row;     // MA of the first character of the current row
+
+    uint32_t frame;  // Completed frames
+    uint64_t clocks; // Character clocks since init
+} mc6845_model_t;
+
+// Reset the counters and load R0-R15, as the firmware does at init.
+void mc6845_model_init(mc6845_model_t *crtc, const uint8_t regs[16]);
+
+// Direct register write (R0-R15), masked to the register width of the real chip.
+void mc6845_model_write(mc6845_model_t *crtc, uint8_t reg, uint8_t value);
+
+// 6800-style bus write latched on the E falling edge: RS=0 selects the register, RS=1 writes it.
+void mc6845_model_bus_write(mc6845_model_t *crtc, bool rs, uint8_t value);
+
+// Output the pins for the current character clock, then advance by one character.
+void mc6845_model_clock(mc6845_model_t *crtc, mc6845_outputs_t *out);
+
+// Character clocks per frame for a register set: (R0+1) * ((R4+1) * (R9+1) + R5)
+uint32_t mc6845_model_frame_clocks(const uint8_t regs[16]);
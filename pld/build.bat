@@ -2,4 +2,7 @@
 galette character.pld
 galette attribute.pld
 galette graphics.pld
-galette clock-divider.pld
\ No newline at end of file
+galette graphics640.pld
+galette clock-divider.pld
+galette isa-io-rp2040.pld
+galette isa-vram-rp2040.pld
\ No newline at end of file
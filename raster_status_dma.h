@@ -0,0 +1,95 @@
+#pragma once
+
+// DMA around the 3DAh status engine (raster_status_pio.h). No CPU involvement once
+// started:
+//
+//   timeline[0..words) --------------> raster_status TX   (then the reload channel
+//   &timeline ----------------------> feed.READ_ADDR_TRIG  starts it over)
+//   raster_status RX --[status]------> *target
+//
+// The store is a pair of channels chained to each other, as the isa_vram_bus ring,
+// so it never runs dry. The target is a plain byte, or on CGA_ISA_VRAM boards the
+// byte of the window a 3DAh read is answered from (isa_vram_status_byte()).
+
+#include "hardware/dma.h"
+
+#include "raster_status_pio.h"
+
+#define RASTER_STATUS_STORE_WORDS 0xFFFFFFFFu
+
+typedef struct {
+    int feed, reload;
+    int store[2];
+    uint offset;
+    const uint32_t *timeline; // Read by the reload channel
+    uint8_t *volatile target;
+} raster_status_dma_t;
+
+static raster_status_dma_t raster_status_dma;
+
+static inline void raster_status_dma_store(const int channel, const int other, uint8_t *target) {
+    dma_channel_config c = dma_channel_get_default_config(channel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(PIO_RASTER, SM_RASTER, false));
+    channel_config_set_chain_to(&c, other);
+    dma_channel_configure(channel, &c, target, &PIO_RASTER->rxf[SM_RASTER], RASTER_STATUS_STORE_WORDS, false);
+}
+
+static inline void raster_status_dma_init(const uint ra0_pin, uint8_t *target) {
+    raster_status_dma.offset = pio_add_program(PIO_RASTER, &raster_status_program);
+    raster_status_program_init(PIO_RASTER, SM_RASTER, raster_status_dma.offset, ra0_pin);
+    raster_status_dma.target = target;
+
+    raster_status_dma.feed = dma_claim_unused_channel(true);
+    raster_status_dma.reload = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(raster_status_dma.feed);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(PIO_RASTER, SM_RASTER, true));
+    channel_config_set_chain_to(&c, raster_status_dma.reload);
+    dma_channel_configure(raster_status_dma.feed, &c, &PIO_RASTER->txf[SM_RASTER], NULL, 0, false);
+
+    c = dma_channel_get_default_config(raster_status_dma.reload);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    dma_channel_configure(raster_status_dma.reload, &c, &dma_hw->ch[raster_status_dma.feed].al3_read_addr_trig,
+                          &raster_status_dma.timeline, 1, false);
+
+    raster_status_dma.store[0] = dma_claim_unused_channel(true);
+    raster_status_dma.store[1] = dma_claim_unused_channel(true);
+    raster_status_dma_store(raster_status_dma.store[0], raster_status_dma.store[1], target);
+    raster_status_dma_store(raster_status_dma.store[1], raster_status_dma.store[0], target);
+    dma_start_channel_mask(1u << raster_status_dma.store[0]);
+}
+
+__always_inline static void raster_status_dma_stop(void) {
+    pio_sm_set_enabled(PIO_RASTER, SM_RASTER, false);
+    dma_channel_abort(raster_status_dma.reload);
+    dma_channel_abort(raster_status_dma.feed);
+}
+
+// Play `timeline` from the next RA0 rising edge on; called during line 0 of row 0
+__always_inline static void raster_status_dma_start(const uint32_t *timeline, const uint32_t words) {
+    raster_status_dma_stop();
+    raster_status_dma.timeline = timeline;
+    raster_status_restart(PIO_RASTER, SM_RASTER, raster_status_dma.offset, false);
+    dma_channel_set_trans_count(raster_status_dma.feed, words, false);
+    dma_channel_set_read_addr(raster_status_dma.feed, timeline, true);
+    pio_sm_set_enabled(PIO_RASTER, SM_RASTER, true);
+}
+
+// The window moved (page flip, mode switch): carry the current status over
+__always_inline static void raster_status_dma_set_target(uint8_t *target) {
+    *target = *raster_status_dma.target;
+    dma_channel_set_write_addr(raster_status_dma.store[0], target, false);
+    dma_channel_set_write_addr(raster_status_dma.store[1], target, false);
+    raster_status_dma.target = target;
+}
+
+__always_inline static uint8_t raster_status_dma_get(void) {
+    return *(volatile const uint8_t *) raster_status_dma.target;
+}
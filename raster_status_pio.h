@@ -0,0 +1,68 @@
+// Not generated: this header is kept by hand. raster_status.pio is the source of truth
+// for the program; the instruction table, wrap, sync offset and default config below are
+// pioasm's output for it. The SM choice and the init/restart helpers are hand-written.
+
+#pragma once
+
+#if !PICO_NO_HARDWARE
+#include "hardware/pio.h"
+#endif
+
+// The last free SM of pio1; pio0 has no room left in any build
+#define PIO_RASTER pio1
+#define SM_RASTER 3
+
+// ------------- //
+// raster_status //
+// ------------- //
+
+#define raster_status_wrap_target 2
+#define raster_status_wrap 7
+
+// Where a restart enters the program
+#define raster_status_offset_sync 0
+
+static const uint16_t raster_status_program_instructions[] = {
+    0x2020, //  0: wait   0 pin, 0
+    0x20a0, //  1: wait   1 pin, 0
+            //     .wrap_target
+    0x60c8, //  2: out    isr, 8
+    0x8000, //  3: push   noblock
+    0x6038, //  4: out    x, 24
+    0x2019, //  5: wait   0 gpio, 25
+    0x2099, //  6: wait   1 gpio, 25
+    0x0045, //  7: jmp    x--, 5
+            //     .wrap
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program raster_status_program = {
+    .instructions = raster_status_program_instructions,
+    .length = 8,
+    .origin = -1,
+};
+
+static inline pio_sm_config raster_status_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + raster_status_wrap_target, offset + raster_status_wrap);
+    return c;
+}
+
+// RA0 in, runs from the TX FIFO (fed by DMA), statuses out through the RX FIFO.
+// Left disabled: raster_status_restart() starts it.
+static inline void raster_status_program_init(PIO pio, uint sm, uint offset, uint ra0_pin) {
+    pio_sm_config c = raster_status_program_get_default_config(offset);
+    sm_config_set_in_pins(&c, ra0_pin);
+    sm_config_set_out_shift(&c, true, true, 32);
+    pio_sm_init(pio, sm, offset, &c);
+}
+
+// Stop, drop whatever the FIFOs hold and go back to waiting for RA0
+static inline void raster_status_restart(PIO pio, uint sm, uint offset, bool enable) {
+    pio_sm_set_enabled(pio, sm, false);
+    pio_sm_clear_fifos(pio, sm);
+    pio_sm_restart(pio, sm);
+    pio_sm_exec(pio, sm, pio_encode_jmp(offset + raster_status_offset_sync));
+    pio_sm_set_enabled(pio, sm, enable);
+}
+#endif
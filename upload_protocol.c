@@ -0,0 +1,121 @@
+#include "upload_protocol.h"
+
+#include <string.h>
+
+// Reflected CRC-32 (0xEDB88320) a nibble at a time: 64 bytes of table instead of 1 KB,
+// and still well under the cost of moving the byte through USB
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t upload_crc32(uint32_t crc, const uint8_t *data, const size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = crc >> 4 ^ crc32_nibble[crc & 15];
+        crc = crc >> 4 ^ crc32_nibble[crc & 15];
+    }
+    return ~crc;
+}
+
+static inline uint16_t get16(const uint8_t *p) {
+    return p[0] | p[1] << 8;
+}
+
+static inline uint32_t get32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+size_t upload_parse(upload_parser_t *parser, const uint8_t *data, const size_t len, upload_event_t *event) {
+    size_t used = 0;
+    *event = UPLOAD_EVENT_NONE;
+    while (used < len) {
+        if (parser->state == 0) {
+            const uint8_t byte = data[used++];
+            if (byte != UPLOAD_MAGIC0) {
+                if (parser->hunting) {
+                    continue;
+                }
+                parser->key = byte;
+                *event = UPLOAD_EVENT_KEY;
+                return used;
+            }
+            parser->packet[parser->state++] = byte;
+            continue;
+        }
+        if (parser->state == 1) {
+            // Not a packet after all: drop the first magic byte, look at this one again
+            if (data[used] != UPLOAD_MAGIC1) {
+                parser->state = 0;
+                continue;
+            }
+            parser->packet[parser->state++] = data[used++];
+            continue;
+        }
+
+        // Header, then payload and CRC, copied in whatever runs the input arrives in
+        const uint32_t need = parser->state < UPLOAD_HEADER_SIZE ? UPLOAD_HEADER_SIZE : parser->need;
+        size_t run = need - parser->state;
+        if (run > len - used) {
+            run = len - used;
+        }
+        memcpy(&parser->packet[parser->state], &data[used], run);
+        parser->state += run;
+        used += run;
+        if (parser->state != need) {
+            continue;
+        }
+
+        if (need == UPLOAD_HEADER_SIZE) {
+            const uint16_t length = get16(&parser->packet[6]);
+            if (length > UPLOAD_MAX_PAYLOAD) {
+                parser->state = 0;
+                parser->hunting = true;
+                *event = UPLOAD_EVENT_BAD;
+                return used;
+            }
+            parser->need = UPLOAD_HEADER_SIZE + length + UPLOAD_CRC_SIZE;
+            continue;
+        }
+
+        parser->state = 0;
+        const uint8_t *packet = parser->packet;
+        const uint32_t body = parser->need - UPLOAD_CRC_SIZE;
+        if (upload_crc32(0, &packet[2], body - 2) != get32(&packet[body])) {
+            parser->hunting = true;
+            *event = UPLOAD_EVENT_BAD;
+            return used;
+        }
+        parser->hunting = false;
+        parser->type = packet[2];
+        parser->seq = packet[3];
+        parser->offset = get16(&packet[4]);
+        parser->length = get16(&packet[6]);
+        parser->payload = &packet[UPLOAD_HEADER_SIZE];
+        *event = UPLOAD_EVENT_PACKET;
+        return used;
+    }
+    return used;
+}
+
+size_t upload_encode(uint8_t *out, const uint8_t type, const uint8_t seq, const uint16_t offset,
+                     const uint8_t *payload, const uint16_t length) {
+    out[0] = UPLOAD_MAGIC0;
+    out[1] = UPLOAD_MAGIC1;
+    out[2] = type;
+    out[3] = seq;
+    out[4] = offset & 0xFF;
+    out[5] = offset >> 8;
+    out[6] = length & 0xFF;
+    out[7] = length >> 8;
+    if (length) {
+        memcpy(&out[UPLOAD_HEADER_SIZE], payload, length);
+    }
+    const size_t body = UPLOAD_HEADER_SIZE + length;
+    const uint32_t crc = upload_crc32(0, &out[2], body - 2);
+    for (int i = 0; i < 4; i++) {
+        out[body + i] = crc >> (8 * i) & 0xFF;
+    }
+    return body + UPLOAD_CRC_SIZE;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+// Binary upload protocol on the USB CDC console: writes ranges of the back page
+// (text memory, the graphics window), writes and selects fonts, patches it with deltas against the
+// front page (delta_codec.h) and flips pages. Pure C, shared by
+// the firmware (parser) and host tools (encoder, reply parser).
+//
+// Packet, little endian:
+//   0  magic 0xC6 0xA5
+//   2  type              UPLOAD_*
+//   3  sequence number   expected to count up by one, modulo 256
+//   4  offset            byte offset into the region
+//   6  length            payload bytes, at most UPLOAD_MAX_PAYLOAD
+//   8  payload
+//   .. CRC-32 (IEEE, as zlib.crc32) of type .. end of payload
+//
+// Reply, 3 bytes: 0xC6, UPLOAD_ACK + sequence number applied, UPLOAD_NAK + sequence
+// number expected next (bad CRC or a gap: resend from there), or UPLOAD_REJECT + the
+// offending sequence number (bad type or range; counted as received, not applied).
+// A packet repeating the last applied sequence number is acknowledged again and not
+// applied twice, so a lost ACK costs a resend and nothing else.
+//
+// Bytes outside a packet are console keys ('t', 'g', ...), so the same port keeps
+// working from a terminal; neither magic byte is a command. After a bad packet the
+// bytes up to the next good one are dropped, not taken for keys: a damaged length
+// field leaves the parser in the middle of the next packet's payload.
+// Console text can appear between replies, readers look for the reply magic.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define UPLOAD_MAGIC0 0xC6
+#define UPLOAD_MAGIC1 0xA5
+#define UPLOAD_HEADER_SIZE 8
+#define UPLOAD_CRC_SIZE 4
+#define UPLOAD_MAX_PAYLOAD 4096 // A 16 KB graphics frame is four packets
+#define UPLOAD_MAX_PACKET (UPLOAD_HEADER_SIZE + UPLOAD_MAX_PAYLOAD + UPLOAD_CRC_SIZE)
+#define UPLOAD_REPLY_SIZE 3
+
+enum {
+    UPLOAD_SYNC = 0,           // Restart numbering: the next expected sequence number is this one + 1
+    UPLOAD_TEXT = 1,           // Char/attr pairs as at B8000, back page
+    UPLOAD_GRAPHICS = 2,       // The 16 KB window as at B8000 (odd scanlines from 0x2000), back page
+    UPLOAD_FONT = 3,           // font_slots as one block, [char][row]; pages using a font touched are re-expanded
+    UPLOAD_FLIP = 4,           // Show the back page from the next vertical blank; no payload
+    UPLOAD_TEXT_DELTA = 5,     // delta_codec.h stream against the front page, text window offset
+    UPLOAD_GRAPHICS_DELTA = 6, // The same for the graphics window
+    UPLOAD_PORT = 7,           // OUTs to 3D4h/3D5h/3D8h/3D9h (cga_io.h): (port & 0xFF, value) pairs
+    UPLOAD_FONT_SELECT = 8,    // Font for the back page: offset = slot, one payload byte = glyph rows (FONT_ROWS)
+};
+
+// An UPLOAD_PORT packet is applied whole or rejected: a 3D8h write that changes the
+// mode may only share it with 3D4h/3D9h writes, 3D5h writes go out as one set
+// (a full R0-R15 table fits)
+
+enum {
+    UPLOAD_ACK = 0x06,
+    UPLOAD_NAK = 0x15,
+    UPLOAD_REJECT = 0x18,
+};
+
+uint32_t upload_crc32(uint32_t crc, const uint8_t *data, size_t len);
+
+// ---------------- Device side ----------------
+
+typedef enum {
+    UPLOAD_EVENT_NONE,   // Input used up
+    UPLOAD_EVENT_KEY,    // A console key outside a packet: key
+    UPLOAD_EVENT_PACKET, // A packet with a good CRC: type, seq, offset, length, payload
+    UPLOAD_EVENT_BAD,    // A packet with a bad CRC or length; hunting for the next one
+} upload_event_t;
+
+typedef struct {
+    uint32_t state; // Bytes of the current packet seen, 0 = between packets
+    uint32_t need;  // Total size of the current packet once the header is in
+    bool hunting;   // Since a bad packet: no keys until a good packet
+    uint8_t packet[UPLOAD_MAX_PACKET];
+
+    // Last event
+    uint8_t key;
+    uint8_t type, seq;
+    uint16_t offset, length;
+    const uint8_t *payload;
+} upload_parser_t;
+
+static inline void upload_parser_init(upload_parser_t *parser) {
+    parser->state = 0;
+    parser->hunting = false;
+}
+
+// Consume input up to and including the next event and return the bytes used.
+// The caller handles the event before feeding the rest.
+size_t upload_parse(upload_parser_t *parser, const uint8_t *data, size_t len, upload_event_t *event);
+
+// ---------------- Host side ----------------
+
+// Build a packet into out (UPLOAD_MAX_PACKET bytes) and return its size
+size_t upload_encode(uint8_t *out, uint8_t type, uint8_t seq, uint16_t offset, const uint8_t *payload,
+                     uint16_t length);
+
+static inline void upload_reply(uint8_t out[UPLOAD_REPLY_SIZE], const uint8_t status, const uint8_t seq) {
+    out[0] = UPLOAD_MAGIC0;
+    out[1] = status;
+    out[2] = seq;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// DMA address-to-data lookup chain for the PIO video engine (video_pio.h).
+// No CPU involvement per fetch:
+//
+//   video_addr_dma RX --[addr]--> byte.READ_ADDR_TRIG
+//   byte:  table[RA][MA] --------> video_data TX (glyph|attr pair, or a pixel byte)
+//
+// Text modes read the pre-expanded row planes (text_rows), graphics the
+// framebuffer, so every mode is a single hop. The reader channel moves one word
+// and is re-armed by the chain_to of the channel it triggered, so the ring runs
+// forever at one entry per character.
+
+#include "hardware/dma.h"
+#include "hardware/structs/busctrl.h"
+
+#include "video_memory.h"
+#include "video_pio.h"
+
+typedef struct {
+    int addr, byte;
+    uint program_offset; // video_addr_dma, for the per-mode patching
+} video_dma_t;
+
+static video_dma_t video_dma;
+
+// Pointer from a PIO RX FIFO into the READ_ADDR_TRIG of the next channel
+static inline void video_dma_ring_reader(const int channel, const int target, PIO pio, const uint sm) {
+    dma_channel_config c = dma_channel_get_default_config(channel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(pio, sm, false));
+    channel_config_set_high_priority(&c, true);
+    dma_channel_configure(channel, &c, &dma_hw->ch[target].al3_read_addr_trig, &pio->rxf[sm], 1, false);
+}
+
+// One entry from the triggered address into a PIO TX FIFO, then re-arm the reader.
+// The transfer size is set per mode by video_dma_set_layout().
+static inline void video_dma_ring_lookup(const int channel, const int reader, PIO pio, const uint sm) {
+    dma_channel_config c = dma_channel_get_default_config(channel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_chain_to(&c, reader);
+    channel_config_set_high_priority(&c, true);
+    dma_channel_configure(channel, &c, &pio->txf[sm], NULL, 1, false);
+}
+
+__always_inline static void video_dma_set_layout(const video_dma_layout_t *layout) {
+    // Text entries are 16-bit pairs; an 8-bit graphics byte lands replicated in the FIFO word
+    const uint size = layout->entry_shift ? DMA_SIZE_16 : DMA_SIZE_8;
+    hw_write_masked(&dma_hw->ch[video_dma.byte].al1_ctrl, size << DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB,
+                    DMA_CH0_CTRL_TRIG_DATA_SIZE_BITS);
+    video_addr_dma_set_layout(PIO_VIDEO, SM_VIDEO_ADDR, video_dma.program_offset, (uintptr_t) layout->table,
+                              layout->ma_bits, layout->row_bits, layout->entry_shift);
+}
+
+static inline void video_dma_init(const uint addr_pin_base, const uint data_pin_base, const video_dma_layout_t *layout) {
+    PIO pio = PIO_VIDEO;
+    video_dma.program_offset = init_video_pio_dma(pio, addr_pin_base, data_pin_base);
+
+    video_dma.addr = dma_claim_unused_channel(true);
+    video_dma.byte = dma_claim_unused_channel(true);
+
+    video_dma_ring_reader(video_dma.addr, video_dma.byte, pio, SM_VIDEO_ADDR);
+    video_dma_ring_lookup(video_dma.byte, video_dma.addr, pio, SM_VIDEO_DATA);
+
+    // The fetch chain must not wait behind the CPUs on the bus fabric
+    bus_ctrl_hw->priority = BUSCTRL_BUS_PRIORITY_DMA_W_BITS | BUSCTRL_BUS_PRIORITY_DMA_R_BITS;
+
+    video_dma_set_layout(layout);
+    dma_start_channel_mask(1u << video_dma.addr);
+    pio_enable_sm_mask_in_sync(pio, 1u << SM_VIDEO_ADDR | 1u << SM_VIDEO_DATA);
+}
@@ -0,0 +1,259 @@
+#include "video_memory.h"
+
+#include <string.h>
+
+#include "board.h"
+#include "delta_codec.h"
+#include "hal.h"
+// rom.h, or the font CMake had host/fontc.py compile (CGA_FONT, CGA_FONT_LSB_FIRST)
+#ifdef CGA_FONT_HEADER
+#include CGA_FONT_HEADER
+#else
+#include "rom.h"
+#endif
+
+// SRAM placement. Nothing on the fetch path may come from XIP flash: at 400 MHz
+// with PICO_FLASH_SPI_CLKDIV=4 a cache miss costs hundreds of cycles.
+//   SRAM0..3 (striped): text_rows, graphics_buffer, tweak_cells - read per character
+//                       by the DMA chain or core 1; text_buffer (2 x 4 KB char+attr,
+//                       too big to share a scratch bank with a stack). Both pages of
+//                       everything come to 136 KB, font_slots to 8 KB more.
+// Fonts are only read when cells are written (core 0, and core 1 for ISA writes), never
+// by a fetch.
+// Each table shows up under its own section in the linker map (bin/CGA.elf.map).
+// Each page keeps the alignment of a single buffer, the page stride is its size
+uint16_t text_rows[VIDEO_PAGES][1 << TEXT_ROW_BITS][1 << TEXT_INDEX_BITS]
+    __attribute__((aligned(2 << (TEXT_ROW_BITS + TEXT_INDEX_BITS))));
+uint8_t graphics_buffer[VIDEO_PAGES][1 << GRAPHICS_BANK_BITS][1 << GRAPHICS_INDEX_BITS]
+    __attribute__((aligned(1 << (GRAPHICS_BANK_BITS + GRAPHICS_INDEX_BITS))));
+uint16_t tweak_cells[VIDEO_PAGES][1 << GRAPHICS_INDEX_BITS] __attribute__((aligned(2 << GRAPHICS_INDEX_BITS)));
+uint8_t text_buffer[VIDEO_PAGES][2 << TEXT_INDEX_BITS]
+    __attribute__((aligned(2 << TEXT_INDEX_BITS))); // ISA read chain (isa_vram.h)
+uint8_t font_slots[FONT_SLOTS][FONT_SLOT_BYTES];
+video_font_t video_page_font[VIDEO_PAGES];
+uint8_t video_back_page = 1;
+
+// Font video_font_select() set up; the back page follows it
+static video_font_t selected_font;
+// Pages whose font changed under them while on screen, re-expanded once they are back
+static bool font_stale[VIDEO_PAGES];
+
+// Delta frame being built in the back page: window offset reached per window,
+// -1 when none is open
+enum { DELTA_TEXT, DELTA_GRAPHICS };
+static int32_t delta_end[2] = {-1, -1};
+
+// Attributes of [offset, offset + length) of a page's graphics window into tweak_cells
+static void tweak_expand(const uint8_t page, const uint32_t offset, const uint32_t length) {
+    const uint8_t *window = &graphics_buffer[page][0][0];
+    const video_font_t *font = &video_page_font[page];
+    const uint16_t glyph = font->glyphs[TWEAK_GLYPH * font->rows];
+    for (uint32_t i = offset | 1; i < offset + length; i += 2) {
+        tweak_cells[page][i >> 1] = glyph | window[i] << 8;
+    }
+}
+
+static bool font_valid(const uint8_t slot, const uint8_t rows) {
+    return rows == FONT_ROWS && slot < FONT_SLOTS;
+}
+
+// Boot stage: the fonts are copied out of flash once, before anything is expanded.
+// Nothing is scanned out yet, so both pages get the same picture.
+static void font_load(void) {
+    memcpy(font_slots[0], cga_font_8x8, sizeof(cga_font_8x8));
+    selected_font = (video_font_t) {font_slots[0], FONT_ROWS};
+
+    uint8_t header[FONT_FLASH_HEADER_SIZE];
+    hal_flash_read(FONT_FLASH_OFFSET, header, sizeof(header));
+    const uint32_t magic = header[0] | header[1] << 8 | header[2] << 16 | (uint32_t) header[3] << 24;
+    if (magic != FONT_FLASH_MAGIC || !header[4] || header[4] > FONT_SLOTS || header[5] >= header[4] ||
+        !font_valid(header[5], header[6])) {
+        return;
+    }
+    hal_flash_read(FONT_FLASH_OFFSET + FONT_FLASH_HEADER_SIZE, font_slots, header[4] * FONT_SLOT_BYTES);
+    selected_font = (video_font_t) {font_slots[header[5]], header[6]};
+}
+
+void video_memory_init(void) {
+    font_load();
+    for (int page = 0; page < VIDEO_PAGES; page++) {
+        video_page_font[page] = selected_font;
+        video_back_page = page;
+        init_test_patterns(0);
+    }
+    video_back_page = 1;
+}
+
+// Test pattern generation
+void init_test_patterns(const uint8_t phase) {
+    // The whole back page is redrawn, an open delta frame has nothing left to complete
+    delta_end[DELTA_TEXT] = delta_end[DELTA_GRAPHICS] = -1;
+
+    // Text mode: Fill with test characters
+    for (int i = 0; i < TEXT_BUFFER_SIZE; i++) {
+        // ASCII printable chars, one foreground colour per line on black
+        video_text_put(i, 0x20 + (i + phase) % 96, 1 + (i / 80) % 15);
+    }
+
+    // Graphics mode: Fill with test pattern
+    uint8_t (*banks)[1 << GRAPHICS_INDEX_BITS] = graphics_buffer[video_back_page];
+    for (int i = 0; i < GRAPHICS_BUFFER_SIZE; i++) {
+        banks[0][i] = (i + phase) & 0xFF; // Simple pattern, even scanlines
+        banks[1][i] = ~(i + phase) & 0xFF; // Inverted on odd scanlines
+    }
+    tweak_expand(video_back_page, 0, GRAPHICS_WINDOW_BYTES);
+}
+
+void video_text_rebuild(const uint8_t page) {
+    for (int i = 0; i < (1 << TEXT_INDEX_BITS); i++) {
+        video_text_put_page(page, i, text_buffer[page][2 * i], text_buffer[page][2 * i + 1]);
+    }
+    tweak_expand(page, 0, GRAPHICS_WINDOW_BYTES);
+    font_stale[page] = false;
+}
+
+bool video_font_select(const uint8_t slot, const uint8_t rows) {
+    if (!font_valid(slot, rows)) {
+        return false;
+    }
+    selected_font = (video_font_t) {font_slots[slot], rows};
+    video_font_follow();
+    return true;
+}
+
+void video_font_follow(void) {
+    video_font_t *font = &video_page_font[video_back_page];
+    if (font->glyphs != selected_font.glyphs || font->rows != selected_font.rows || font_stale[video_back_page]) {
+        *font = selected_font;
+        video_text_rebuild(video_back_page);
+    }
+}
+
+void video_text_write(const uint16_t offset, const uint8_t *data, const uint16_t length) {
+    uint8_t *text = text_buffer[video_back_page];
+    memcpy(&text[offset], data, length);
+    for (uint32_t cell = offset / 2; cell < (offset + length + 1u) / 2; cell++) {
+        video_text_put(cell, text[2 * cell], text[2 * cell + 1]);
+    }
+}
+
+void video_graphics_write(const uint16_t offset, const uint8_t *data, const uint16_t length) {
+    memcpy(&graphics_buffer[video_back_page][0][0] + offset, data, length);
+    tweak_expand(video_back_page, offset, length);
+}
+
+void video_font_write(const uint16_t offset, const uint8_t *data, const uint16_t length) {
+    memcpy(&font_slots[0][0] + offset, data, length);
+    for (int page = 0; page < VIDEO_PAGES; page++) {
+        const video_font_t *font = &video_page_font[page];
+        const uint32_t start = font->glyphs - &font_slots[0][0];
+        if (offset < start + 256u * font->rows && start < offset + (uint32_t) length) {
+            // The front page is on screen and core 1 stores ISA writes into it: it keeps
+            // the old glyphs until video_font_follow() after the next flip
+            if (page == video_back_page) {
+                video_text_rebuild(page);
+            } else {
+                font_stale[page] = true;
+            }
+        }
+    }
+}
+
+// Store a span of char/attr bytes (stride 0: fill with *src). Only cells whose bytes
+// change are re-expanded, so keeping what the back page already holds costs a compare.
+static void text_store(uint8_t *text, const uint32_t offset, const uint8_t *src, const uint32_t stride,
+                       const uint32_t length) {
+    bool changed = false;
+    for (uint32_t i = offset; i < offset + length; i++, src += stride) {
+        if (text[i] != *src) {
+            text[i] = *src;
+            changed = true;
+        }
+        if ((i & 1) || i + 1 == offset + length) {
+            if (changed) {
+                video_text_put(i >> 1, text[i & ~1u], text[i | 1]);
+            }
+            changed = false;
+        }
+    }
+}
+
+static void delta_store(const int window, const uint32_t offset, const uint8_t *src, const uint32_t stride,
+                        const uint32_t length) {
+    if (window == DELTA_TEXT) {
+        text_store(text_buffer[video_back_page], offset, src, stride, length);
+    } else {
+        if (stride) {
+            memcpy(&graphics_buffer[video_back_page][0][0] + offset, src, length);
+        } else {
+            memset(&graphics_buffer[video_back_page][0][0] + offset, *src, length);
+        }
+        tweak_expand(video_back_page, offset, length);
+    }
+}
+
+static const uint8_t *delta_front(const int window) {
+    const uint8_t front = video_back_page ^ 1;
+    return window == DELTA_TEXT ? text_buffer[front] : &graphics_buffer[front][0][0];
+}
+
+static bool video_delta(const int window, const uint32_t window_bytes, const uint16_t offset,
+                        const uint8_t *stream, const uint16_t length) {
+    const int32_t span = delta_span(stream, length);
+    const uint32_t from = delta_end[window] < 0 ? 0 : delta_end[window];
+    if (span < 0 || offset < from || offset + (uint32_t) span > window_bytes) {
+        return false;
+    }
+    const uint8_t *front = delta_front(window);
+    delta_store(window, from, &front[from], 1, offset - from);
+
+    delta_reader_t reader;
+    delta_run_t run;
+    uint32_t at = offset;
+    delta_reader_init(&reader, stream, length);
+    while (delta_next(&reader, &run)) {
+        if (run.op == DELTA_LITERAL) {
+            delta_store(window, at, run.data, 1, run.length);
+        } else if (run.op == DELTA_FILL) {
+            delta_store(window, at, &run.value, 0, run.length);
+        } else {
+            delta_store(window, at, &front[at], 1, run.length);
+        }
+        at += run.length;
+    }
+    delta_end[window] = at;
+    return true;
+}
+
+bool video_text_delta(const uint16_t offset, const uint8_t *stream, const uint16_t length) {
+    return video_delta(DELTA_TEXT, TEXT_WINDOW_BYTES, offset, stream, length);
+}
+
+bool video_graphics_delta(const uint16_t offset, const uint8_t *stream, const uint16_t length) {
+    return video_delta(DELTA_GRAPHICS, GRAPHICS_WINDOW_BYTES, offset, stream, length);
+}
+
+void video_delta_finish(void) {
+    static const uint32_t window_bytes[2] = {TEXT_WINDOW_BYTES, GRAPHICS_WINDOW_BYTES};
+    for (int window = DELTA_TEXT; window <= DELTA_GRAPHICS; window++) {
+        if (delta_end[window] < 0) continue;
+        const uint32_t from = delta_end[window];
+        delta_store(window, from, &delta_front(window)[from], 1, window_bytes[window] - from);
+        delta_end[window] = -1;
+    }
+}
+
+// One table load at the DMA chain's index; a byte entry is repeated into both halves.
+// The layout arguments are constants, so each expansion compiles to its own few
+// instructions in RAM.
+#define VIDEO_FETCH_KERNEL(name, layout) VIDEO_FETCH_KERNEL_(name, layout)
+#define VIDEO_FETCH_KERNEL_(name, table_, ma_bits, row_bits, entry_t)                                                  \
+    uint16_t __not_in_flash_func(name)(const void *table, const uint32_t sample) {                                     \
+        const uint32_t row = sample >> 14 & ((1u << (row_bits)) - 1);                                                  \
+        const entry_t entry = ((const entry_t *) table)[row << (ma_bits) | (sample & ((1u << (ma_bits)) - 1))];        \
+        return sizeof(entry_t) == 1 ? entry * 0x0101 : entry;                                                          \
+    }
+
+VIDEO_FETCH_KERNEL(video_fetch_text, VIDEO_LAYOUT_TEXT)
+VIDEO_FETCH_KERNEL(video_fetch_graphics, VIDEO_LAYOUT_GRAPHICS)
+VIDEO_FETCH_KERNEL(video_fetch_tweak, VIDEO_LAYOUT_TWEAK)
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "video_modes.h"
+
+// ---------------- Video memory emulation ----------------
+#define TEXT_BUFFER_SIZE (80 * 25)   // Cells; char + attr bytes, 4000 bytes as at B8000
+#define GRAPHICS_BUFFER_SIZE (8000)  // Per bank: 100 lines of 80 bytes, 320x200/4 pixels per byte
+
+// Buffers are allocated as aligned powers of two: MA is masked to the window, so
+// a fetch can never leave the buffer, and the DMA engine builds its read pointer
+// by OR-ing MA (and RA) into the base address.
+#define TEXT_INDEX_BITS     11  // 2048 cells
+#define TEXT_ROW_BITS       3   // RA0..RA2, 8 glyph rows
+#define GRAPHICS_INDEX_BITS 13  // 8192 bytes per bank
+#define GRAPHICS_BANK_BITS  1   // RA0: even/odd scanline bank
+
+// Sizes of the windows as the upload protocol and an ISA host see them
+#define TEXT_WINDOW_BYTES     (2 << TEXT_INDEX_BITS)
+#define GRAPHICS_WINDOW_BYTES (1 << (GRAPHICS_BANK_BITS + GRAPHICS_INDEX_BITS))
+
+// The window a mode is drawn through: text_buffer (cells re-expanded into text_rows)
+// or graphics_buffer (attributes expanded into tweak_cells)
+typedef enum {
+    VIDEO_WINDOW_TEXT,
+    VIDEO_WINDOW_GRAPHICS
+} video_window_t;
+
+// Every buffer exists twice. Core 1 scans out the front page while core 0 draws into
+// the back page; a flip only changes which page the fetch engine reads, in vertical
+// blank, so nothing is copied and no frame shows a half-drawn page.
+#define VIDEO_PAGES 2
+
+// CGA text memory, the source of truth for text modes: character at 2 * cell,
+// attribute at 2 * cell + 1. Write cells through video_text_put() so the row
+// planes follow.
+extern uint8_t text_buffer[VIDEO_PAGES][2 << TEXT_INDEX_BITS];
+// Pre-expanded glyph rows, [RA][MA]: text_rows[r][a] = font[char][r] | attr << 8.
+// A text fetch is a single 16-bit load of the pair video_data puts on D0..D7,
+// for the CPU loop and the DMA chain alike.
+extern uint16_t text_rows[VIDEO_PAGES][1 << TEXT_ROW_BITS][1 << TEXT_INDEX_BITS];
+// CGA framebuffer, [RA0][MA]: physical A13 = RA0, so even scanlines read
+// B8000-B9F3F and odd scanlines BA000-BBF3F. Flattened it is the 16 KB window
+// at B8000 byte for byte; as a table it is the (MA, RA) -> byte mapping.
+extern uint8_t graphics_buffer[VIDEO_PAGES][1 << GRAPHICS_BANK_BITS][1 << GRAPHICS_INDEX_BITS];
+// 160x100 tweak mode: the graphics window read as 8192 char/attr cells, MA = cell.
+// Every cell shows the TWEAK_GLYPH half block, whose rows are all the same, so only
+// attributes are expanded: tweak_cells[c] = glyph row | attribute of cell c << 8.
+// Kept up by every write to the graphics window, whatever mode is on screen; a
+// tweak fetch is one 16-bit load with no RA and no font lookup.
+#define TWEAK_GLYPH 0xDE
+extern uint16_t tweak_cells[VIDEO_PAGES][1 << GRAPHICS_INDEX_BITS];
+
+// Page core 0 draws into; video_text_put() and init_test_patterns() write here
+extern uint8_t video_back_page;
+
+extern const uint8_t cga_font_8x8[2048];
+
+// ---------------- Font slots ----------------
+// Glyphs are [char][row] in FONT_SLOTS RAM slots, one 8x8 font each. Slot 0 starts out
+// as cga_font_8x8, the others are written over USB (UPLOAD_FONT) or loaded from flash at
+// boot.
+// Each page is expanded with a font of its own, so a font selected for the back page
+// shows with the next flip and consecutive frames can use different fonts. Writing a
+// cell only looks at its page's entry: one pointer to the glyphs.
+// The board brings RA0..RA2 out only (TEXT_ROW_BITS), so the row planes hold 8 glyph
+// rows and only 8-row fonts are accepted. 8x14/8x16 fonts (R9 = 13/15) need RA3 on the
+// RP2040 and 16 row planes; the rows field in the flash header and UPLOAD_FONT_SELECT
+// is there for them, and anything but FONT_ROWS is refused until then.
+#define FONT_SLOTS 4
+#define FONT_SLOT_BYTES 2048
+#define FONT_ROWS (1 << TEXT_ROW_BITS)
+
+typedef struct {
+    const uint8_t *glyphs; // Into font_slots
+    uint8_t rows;          // FONT_ROWS
+} video_font_t;
+
+extern uint8_t font_slots[FONT_SLOTS][FONT_SLOT_BYTES];
+extern video_font_t video_page_font[VIDEO_PAGES];
+
+// Font partition in flash at FONT_FLASH_OFFSET (board.h), written with the image; an
+// erased or foreign one is ignored. Little endian header:
+//   0  magic 'C' 'G' 'F' 'S'
+//   4  slots            slot images that follow, FONT_SLOT_BYTES each, from slot 0
+//   5  select           slot to show from boot
+//   6  rows             its glyph rows
+//   7  0
+#define FONT_FLASH_MAGIC 0x53464743u
+#define FONT_FLASH_HEADER_SIZE 8
+
+// Copy the ROM font into slot 0 and the flash partition over the slots, then fill both
+// pages with test patterns
+void video_memory_init(void);
+// Fill the back page with test patterns, shifted by `phase` characters/bytes
+void init_test_patterns(uint8_t phase);
+
+// Store a character cell of a page and expand its 8 glyph rows into text_rows
+static inline void video_text_put_page(const uint8_t page, const uint16_t address, const uint8_t ch,
+                                       const uint8_t attr) {
+    const uint16_t cell = address & ((1 << TEXT_INDEX_BITS) - 1);
+    const video_font_t *font = &video_page_font[page];
+    const uint8_t *glyph = &font->glyphs[ch * font->rows];
+    text_buffer[page][2 * cell] = ch;
+    text_buffer[page][2 * cell + 1] = attr;
+    for (int row = 0; row < (1 << TEXT_ROW_BITS); row++) {
+        text_rows[page][row][cell] = glyph[row] | attr << 8;
+    }
+}
+
+static inline void video_text_put(const uint16_t address, const uint8_t ch, const uint8_t attr) {
+    video_text_put_page(video_back_page, address, ch, attr);
+}
+
+// A byte stored at `offset` of a page's graphics window: an attribute (odd offset)
+// goes into tweak_cells as well
+static inline void video_tweak_put_page(const uint8_t page, const uint32_t offset, const uint8_t value) {
+    if (offset & 1) {
+        const video_font_t *font = &video_page_font[page];
+        tweak_cells[page][offset >> 1 & ((1 << GRAPHICS_INDEX_BITS) - 1)] =
+            font->glyphs[TWEAK_GLYPH * font->rows] | value << 8;
+    }
+}
+
+// Re-expand every cell of a page, text and tweak, e.g. after its font changed
+void video_text_rebuild(uint8_t page);
+
+// Expand the back page with `rows`-row glyphs from `slot` from now on. false unless
+// `rows` is FONT_ROWS and `slot` exists.
+bool video_font_select(uint8_t slot, uint8_t rows);
+// A flip has landed: the new back page takes the selected font as well, and is
+// re-expanded if video_font_write() changed its glyphs while it was on screen
+void video_font_follow(void);
+
+// Bulk writes at window offsets, bounds checked by the caller: char/attr bytes of the
+// back page (row planes follow), the back page's graphics window, font_slots as one
+// block (the back page is re-expanded if it uses a font this touches, the front page
+// after the next flip)
+void video_text_write(uint16_t offset, const uint8_t *data, uint16_t length);
+void video_graphics_write(uint16_t offset, const uint8_t *data, uint16_t length);
+void video_font_write(uint16_t offset, const uint8_t *data, uint16_t length);
+
+// Delta streams (delta_codec.h) against the front page, applied to the back page. The
+// streams of one frame come in window order; false (nothing applied) if a stream is
+// malformed, runs past the window or starts before the previous one ended.
+// video_delta_finish() copies whatever they left out from the front, before a flip.
+// A frame uses either these or the bulk writes above for a window, not both.
+bool video_text_delta(uint16_t offset, const uint8_t *stream, uint16_t length);
+bool video_graphics_delta(uint16_t offset, const uint8_t *stream, uint16_t length);
+void video_delta_finish(void);
+
+// ---------------- Fetch kernels ----------------
+// Bytes the RP2040 has to put on D0-D7 for an MA/RA sample (GPIO0..16, as captured):
+// glyph row in the low byte, attribute in the high byte. `table` is the page the
+// fetch engine shows, the same base the DMA chain reads from.
+// Each kernel is generated from the traits of one buffer layout below, so the masks,
+// shifts and entry width are constants and a kernel is one load, with no mode or page
+// to look at: the fetch loop is handed the mode's kernel and table at a switch
+// (video_registry.h) and calls nothing else. cga_sim kernels times them.
+// Graphics modes have no attribute and repeat the pixel byte, as the 8-bit DMA write
+// into the FIFO does: 320x200 reads it as four 2-bit pixels, 640x200 (80 MA per line,
+// the real CGA layout) as eight 1-bit ones shifted out by graphics640.pld.
+// The 160x100 tweak mode is text at graphics size: the pair comes from tweak_cells,
+// whatever RA is.
+//
+// Layout traits: table, MA bits, RA bits, entry type
+#define VIDEO_LAYOUT_TEXT     text_rows, TEXT_INDEX_BITS, TEXT_ROW_BITS, uint16_t
+#define VIDEO_LAYOUT_GRAPHICS graphics_buffer, GRAPHICS_INDEX_BITS, GRAPHICS_BANK_BITS, uint8_t
+#define VIDEO_LAYOUT_TWEAK    tweak_cells, GRAPHICS_INDEX_BITS, 0, uint16_t
+
+uint16_t video_fetch_text(const void *table, uint32_t sample);
+uint16_t video_fetch_graphics(const void *table, uint32_t sample);
+uint16_t video_fetch_tweak(const void *table, uint32_t sample);
+
+#if VIDEO_FETCH_ASM
+// video_fetch.S: the whole CPU fetch loop for one layout, in assembly with a fixed
+// cycle count per fetch. Serves every sample waiting in `pio`'s capture FIFO on `table`
+// and returns when it is empty (hal_video_fetch_loop()).
+typedef void (*video_fetch_loop_t)(const void *table, volatile void *pio);
+void video_fetch_loop_text(const void *table, volatile void *pio);
+void video_fetch_loop_graphics(const void *table, volatile void *pio);
+void video_fetch_loop_tweak(const void *table, volatile void *pio);
+#endif
+
+// ---------------- DMA lookup chain ----------------
+// One read per fetch: table[RA[row_bits-1:0] << ma_bits | MA[ma_bits-1:0]].
+// Text modes read the 16-bit row planes (RA0..RA2), graphics the framebuffer
+// banks (RA0) a byte at a time, 160x100 the 16-bit tweak cells (no RA).
+typedef struct {
+    const void *table; // Aligned to 1 << (ma_bits + row_bits + entry_shift)
+    uint8_t ma_bits;
+    uint8_t row_bits;
+    uint8_t entry_shift; // log2 of the entry size: 1 = glyph|attr pairs, 0 = bytes
+} video_dma_layout_t;
+
+// Reference model of what the DMA chain reads for one MA/RA sample, using the
+// same base | index pointer arithmetic as the PIO/DMA hardware
+static inline uint16_t video_dma_lookup(const video_dma_layout_t *layout, const uint32_t sample) {
+    const uintptr_t row = sample >> 14 & ((1u << layout->row_bits) - 1);
+    const uintptr_t index = (row << layout->ma_bits | (sample & ((1u << layout->ma_bits) - 1))) << layout->entry_shift;
+    const uintptr_t address = (uintptr_t) layout->table | index;
+    return layout->entry_shift ? *(const uint16_t *) address : *(const uint8_t *) address * 0x0101;
+}
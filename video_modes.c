@@ -0,0 +1,106 @@
+#include "video_modes.h"
+
+// MC6845 register values for CGA 40x25 Text Mode
+const uint8_t mc6845_cga_40x25[16] = {
+    0x38, // R0: Horizontal Total (56)
+    0x28, // R1: Horizontal Displayed (40)
+    0x2D, // R2: HSync Position (45)
+    0x0A, // R3: HSync Width (10)
+    0x1F, // R4: Vertical Total (31)
+    0x06, // R5: VTotal Adjust (6)
+    0x19, // R6: Vertical Displayed (25)
+    0x1C, // R7: VSync Position (28)
+    0x02, // R8: Interlace Mode (Non-interlaced)
+    0x07, // R9: Max Scanline Address (7, for 8 lines per char)
+    0x00, // R10: Cursor Start Line (6)
+    0x07, // R11: Cursor End Line (7)
+    0x00, // R12: Start Addr (H)
+    0x00, // R13: Start Addr (L)
+    0x00, // R14: Cursor Addr (H)
+    0x00 // R15: Cursor Addr (L)
+};
+
+// MC6845 register values for CGA 80x25 Text Mode
+const uint8_t mc6845_cga_80x25[16] = {
+    0x71, // R0: Horizontal Total (113)
+    0x50, // R1: Horizontal Displayed (80)
+    0x5A, // R2: HSync Position (90)
+    0x0A, // R3: HSync Width (10)
+    0x1F, // R4: Vertical Total (31)
+    0x06, // R5: VTotal Adjust (6)
+    0x19, // R6: Vertical Displayed (25)
+    0x1C, // R7: VSync Position (28)
+    0x02, // R8: Interlace Mode (Non-interlaced)
+    0x07, // R9: Max Scanline Address (7, for 8 lines per char)
+    0x00, // R10: Cursor Start Line (6)
+    0x07, // R11: Cursor End Line (7)
+    0x00, // R12: Start Addr (H)
+    0x00, // R13: Start Addr (L)
+    0x00, // R14: Cursor Addr (H)
+    0x00 // R15: Cursor Addr (L)
+};
+
+// MC6845 register values for CGA 320x200 4-Color Graphics Mode
+const uint8_t mc6845_cga_320x200[16] = {
+    0x38, // R0: Horizontal Total (56)
+    0x28, // R1: Horizontal Displayed (40)
+    0x2D, // R2: HSync Position (45)
+    0x0A, // R3: HSync Width (10)
+    0x7F, // R4: Vertical Total (127)
+    0x06, // R5: VTotal Adjust (6)
+    0x64, // R6: Vertical Displayed (100)
+    0x70, // R7: VSync Position (112)
+    0x02, // R8: Interlace Mode (Non-interlaced)
+    0x01, // R9: Max Scanline Address (1, for 2 lines per "char row")
+    0x00, // R10: Cursor Start (Cursor typically disabled)
+    0x00, // R11: Cursor End (Cursor typically disabled)
+    0x00, // R12: Start Addr (H)
+    0x00, // R13: Start Addr (L)
+    0x00, // R14: Cursor Addr (H)
+    0x00 // R15: Cursor Addr (L)
+};
+
+// MC6845 register values for CGA 640x200 2-Color Graphics Mode
+// Horizontal timings of 80x25 (80 characters of 8 DOTCLKs at 14.31818 MHz, one
+// byte each), vertical ones of 320x200: 100 rows of 2 scanlines, RA0 picks the bank.
+const uint8_t mc6845_cga_640x200[16] = {
+    0x71, // R0: Horizontal Total (113)
+    0x50, // R1: Horizontal Displayed (80)
+    0x5A, // R2: HSync Position (90)
+    0x0A, // R3: HSync Width (10)
+    0x7F, // R4: Vertical Total (127)
+    0x06, // R5: VTotal Adjust (6)
+    0x64, // R6: Vertical Displayed (100)
+    0x70, // R7: VSync Position (112)
+    0x02, // R8: Interlace Mode (Non-interlaced)
+    0x01, // R9: Max Scanline Address (1, for 2 lines per "char row")
+    0x00, // R10: Cursor Start (Cursor typically disabled)
+    0x00, // R11: Cursor End (Cursor typically disabled)
+    0x00, // R12: Start Addr (H)
+    0x00, // R13: Start Addr (L)
+    0x00, // R14: Cursor Addr (H)
+    0x00 // R15: Cursor Addr (L)
+};
+
+// MC6845 register values for the 160x100 16-Color "tweaked text" Mode
+// 80x25 text with two scanlines per row: 100 rows of 80 cells, each cell the 0xDE
+// half block with its background and foreground colour as the left and right pixel.
+// 8000 cells, the whole 16 KB at B8000. Blink has to be off in 3D8h (09h).
+const uint8_t mc6845_cga_160x100[16] = {
+    0x71, // R0: Horizontal Total (113)
+    0x50, // R1: Horizontal Displayed (80)
+    0x5A, // R2: HSync Position (90)
+    0x0A, // R3: HSync Width (10)
+    0x7F, // R4: Vertical Total (127)
+    0x06, // R5: VTotal Adjust (6)
+    0x64, // R6: Vertical Displayed (100)
+    0x70, // R7: VSync Position (112)
+    0x02, // R8: Interlace Mode (Non-interlaced)
+    0x01, // R9: Max Scanline Address (1, for 2 lines per row)
+    0x20, // R10: Cursor Start (cursor not displayed)
+    0x00, // R11: Cursor End
+    0x00, // R12: Start Addr (H)
+    0x00, // R13: Start Addr (L)
+    0x00, // R14: Cursor Addr (H)
+    0x00 // R15: Cursor Addr (L)
+};
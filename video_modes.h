@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+// ---------------- Video modes ----------------
+typedef enum {
+    VIDEO_MODE_TEXT_80x25 = 0,
+    VIDEO_MODE_TEXT_40x25 = 1,
+    VIDEO_MODE_GRAPHICS = 2,     // 320x200, 2 bpp
+    VIDEO_MODE_GRAPHICS_640 = 3, // 640x200, 1 bpp: same banks, 80 bytes a line
+    VIDEO_MODE_TEXT_160x100 = 4, // 80x25 text with R9 = 1 and the 0xDE half block: 16 colours
+    VIDEO_MODE_COUNT
+} video_mode_t;
+
+// MC6845 R0-R15 tables, shared by the firmware and the host-side CRTC model
+extern const uint8_t mc6845_cga_40x25[16];
+extern const uint8_t mc6845_cga_80x25[16];
+extern const uint8_t mc6845_cga_320x200[16];
+extern const uint8_t mc6845_cga_640x200[16];
+extern const uint8_t mc6845_cga_160x100[16];
@@ -0,0 +1,213 @@
+// Kept by hand, not generated: the build does not run pioasm. video.pio is the source
+// of truth for the three programs; their instruction tables, wraps and default configs
+// below are pioasm's output for it and are copied in again after every edit there.
+// The SM numbers, latencies and the init/patch helpers exist only here.
+
+#pragma once
+
+#if !PICO_NO_HARDWARE
+#include "hardware/pio.h"
+#endif
+
+#define PIO_VIDEO pio0
+#define SM_VIDEO_ADDR 0
+#define SM_VIDEO_DATA 2
+
+// DOTCLK falling edges between the address capture and the glyph row / attribute output
+#define VIDEO_DATA_LATENCY 4
+#define VIDEO_ATTR_LATENCY 6
+
+// ---------- //
+// video_addr //
+// ---------- //
+
+#define video_addr_wrap_target 0
+#define video_addr_wrap 5
+
+static const uint16_t video_addr_program_instructions[] = {
+            //     .wrap_target
+    0x2019, //  0: wait   0 gpio, 25
+    0x2099, //  1: wait   1 gpio, 25
+    0x4011, //  2: in     pins, 17
+    0xa026, //  3: mov    x, isr
+    0x00a6, //  4: jmp    x != y, 6
+    0xa0c3, //  5: mov    isr, null
+            //     .wrap
+    0xa041, //  6: mov    y, x
+    0x8000, //  7: push   noblock
+    0xc000, //  8: irq    nowait 0
+    0x0000, //  9: jmp    0
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program video_addr_program = {
+    .instructions = video_addr_program_instructions,
+    .length = 10,
+    .origin = -1,
+};
+
+static inline pio_sm_config video_addr_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + video_addr_wrap_target, offset + video_addr_wrap);
+    return c;
+}
+#endif
+
+// -------------- //
+// video_addr_dma //
+// -------------- //
+
+#define video_addr_dma_wrap_target 0
+#define video_addr_dma_wrap 5
+
+// Instructions rewritten with the mode's index widths
+#define video_addr_dma_offset_base_bits 7
+#define video_addr_dma_offset_row_bits 11
+#define video_addr_dma_offset_ma_bits 12
+#define video_addr_dma_offset_entry_shift 13
+
+static const uint16_t video_addr_dma_program_instructions[] = {
+            //     .wrap_target
+    0x2019, //  0: wait   0 gpio, 25
+    0x2099, //  1: wait   1 gpio, 25
+    0x4011, //  2: in     pins, 17
+    0xa026, //  3: mov    x, isr
+    0x00a6, //  4: jmp    x != y, 6
+    0xa0c3, //  5: mov    isr, null
+            //     .wrap
+    0xa041, //  6: mov    y, x
+    0x40f1, //  7: in     osr, 17
+    0xa027, //  8: mov    x, osr
+    0xa0e2, //  9: mov    osr, y
+    0x606e, // 10: out    null, 14
+    0x40e3, // 11: in     osr, 3
+    0x404b, // 12: in     y, 11
+    0x4061, // 13: in     null, 1
+    0xa0e1, // 14: mov    osr, x
+    0x8000, // 15: push   noblock
+    0xc000, // 16: irq    nowait 0
+    0x0000, // 17: jmp    0
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program video_addr_dma_program = {
+    .instructions = video_addr_dma_program_instructions,
+    .length = 18,
+    .origin = -1,
+};
+
+static inline pio_sm_config video_addr_dma_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + video_addr_dma_wrap_target, offset + video_addr_dma_wrap);
+    return c;
+}
+#endif
+
+// ---------- //
+// video_data //
+// ---------- //
+
+#define video_data_wrap_target 0
+#define video_data_wrap 13
+
+static const uint16_t video_data_program_instructions[] = {
+            //     .wrap_target
+    0x20c0, //  0: wait   1 irq, 0
+    0xe043, //  1: set    y, 3
+    0x2099, //  2: wait   1 gpio, 25
+    0x2019, //  3: wait   0 gpio, 25
+    0x0082, //  4: jmp    y--, 2
+    0x00ed, //  5: jmp    !osre, 13
+    0x8080, //  6: pull   noblock
+    0xa027, //  7: mov    x, osr
+    0xa045, //  8: mov    y, status
+    0x0066, //  9: jmp    !y, 6
+    0x6008, // 10: out    pins, 8
+    0xe041, // 11: set    y, 1
+    0x0002, // 12: jmp    2
+    0x6008, // 13: out    pins, 8
+            //     .wrap
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program video_data_program = {
+    .instructions = video_data_program_instructions,
+    .length = 14,
+    .origin = -1,
+};
+
+static inline pio_sm_config video_data_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + video_data_wrap_target, offset + video_data_wrap);
+    return c;
+}
+
+// MA0..MA13/RA0..RA2 capture into the RX FIFO
+static inline void video_addr_program_init(PIO pio, uint sm, uint offset, uint addr_pin_base) {
+    pio_sm_config c = video_addr_program_get_default_config(offset);
+    sm_config_set_in_pins(&c, addr_pin_base);
+    sm_config_set_in_shift(&c, false, false, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+    pio_sm_set_consecutive_pindirs(pio, sm, addr_pin_base, 17, false);
+    pio_sm_init(pio, sm, offset, &c);
+    pio_sm_exec(pio, sm, pio_encode_mov_not(pio_y, pio_null)); // No previous sample yet
+}
+
+// MA/RA capture pushing DMA read pointers; call video_addr_dma_set_layout() before enabling
+static inline void video_addr_dma_program_init(PIO pio, uint sm, uint offset, uint addr_pin_base) {
+    pio_sm_config c = video_addr_dma_program_get_default_config(offset);
+    sm_config_set_in_pins(&c, addr_pin_base);
+    sm_config_set_in_shift(&c, false, false, 32);
+    sm_config_set_out_shift(&c, true, false, 32);
+    pio_sm_set_consecutive_pindirs(pio, sm, addr_pin_base, 17, false);
+    pio_sm_init(pio, sm, offset, &c);
+}
+
+// Point the capture at a new table: patch the index widths, restart, run the prologue
+__always_inline static void video_addr_dma_set_layout(PIO pio, uint sm, uint offset, uintptr_t base,
+                                                      uint ma_bits, uint row_bits, uint entry_shift) {
+    const uint index_bits = ma_bits + row_bits + entry_shift;
+    const bool enabled = pio->ctrl & (1u << sm);
+    pio_sm_set_enabled(pio, sm, false);
+    pio->instr_mem[offset + video_addr_dma_offset_base_bits] = pio_encode_in(pio_osr, 32 - index_bits);
+    pio->instr_mem[offset + video_addr_dma_offset_row_bits] = row_bits ? pio_encode_in(pio_osr, row_bits)
+                                                                       : pio_encode_nop();
+    pio->instr_mem[offset + video_addr_dma_offset_ma_bits] = pio_encode_in(pio_y, ma_bits);
+    pio->instr_mem[offset + video_addr_dma_offset_entry_shift] = entry_shift ? pio_encode_in(pio_null, entry_shift)
+                                                                             : pio_encode_nop();
+    pio_sm_clear_fifos(pio, sm);
+    pio_sm_restart(pio, sm);
+    pio_sm_put(pio, sm, base >> index_bits);
+    pio_sm_exec(pio, sm, pio_encode_pull(false, true));
+    pio_sm_exec(pio, sm, pio_encode_mov_not(pio_y, pio_null)); // No previous sample yet
+    pio_sm_exec(pio, sm, pio_encode_jmp(offset));
+    pio_sm_set_enabled(pio, sm, enabled);
+}
+
+// D0..D7 output from the TX FIFO, glyph|attr pairs
+static inline void video_data_program_init(PIO pio, uint sm, uint offset, uint data_pin_base) {
+    pio_sm_config c = video_data_program_get_default_config(offset);
+    sm_config_set_out_pins(&c, data_pin_base, 8);
+    sm_config_set_out_shift(&c, true, false, 16);
+    sm_config_set_mov_status(&c, STATUS_TX_LESSTHAN, 1);
+    for (uint pin = data_pin_base; pin < data_pin_base + 8; pin++) {
+        pio_gpio_init(pio, pin);
+    }
+    pio_sm_set_consecutive_pindirs(pio, sm, data_pin_base, 8, true);
+    pio_sm_init(pio, sm, offset, &c);
+}
+#endif
+
+static inline void init_video_pio(PIO pio, uint addr_pin_base, uint data_pin_base) {
+    video_addr_program_init(pio, SM_VIDEO_ADDR, pio_add_program(pio, &video_addr_program), addr_pin_base);
+    video_data_program_init(pio, SM_VIDEO_DATA, pio_add_program(pio, &video_data_program), data_pin_base);
+    // Both start on the same cycle so the IRQ 0 handshake begins in step
+    pio_enable_sm_mask_in_sync(pio, 1u << SM_VIDEO_ADDR | 1u << SM_VIDEO_DATA);
+}
+
+static inline uint init_video_pio_dma(PIO pio, uint addr_pin_base, uint data_pin_base) {
+    const uint offset = pio_add_program(pio, &video_addr_dma_program);
+    video_addr_dma_program_init(pio, SM_VIDEO_ADDR, offset, addr_pin_base);
+    video_data_program_init(pio, SM_VIDEO_DATA, pio_add_program(pio, &video_data_program), data_pin_base);
+    return offset;
+}
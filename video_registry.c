@@ -0,0 +1,75 @@
+#include "video_registry.h"
+
+#include "board.h"
+#include "cga_io.h"
+#include "hal.h"
+
+// Buffer geometry from a layout's traits (video_memory.h), the ones its kernel is built from
+#define GEOMETRY(layout) GEOMETRY_(layout)
+#define GEOMETRY_(table_, ma, row, entry_t)                                                                            \
+    .table = table_, .page_bytes = sizeof(table_[0]), .ma_bits = ma, .row_bits = row,                                  \
+    .entry_shift = sizeof(entry_t) / 2
+#define TEXT_ROWS_GEOMETRY GEOMETRY(VIDEO_LAYOUT_TEXT), .window = VIDEO_WINDOW_TEXT
+#define GRAPHICS_GEOMETRY  GEOMETRY(VIDEO_LAYOUT_GRAPHICS), .window = VIDEO_WINDOW_GRAPHICS
+// DOTCLK and what core 1 derives from it, fixed at build time so nothing in the blank
+// touches floats: the clock SM divider (two SM cycles per DOTCLK, 8 fraction bits
+// truncated as the SDK does) and the CHARCLK rate
+#define DOTCLK(hz)                                                                                                     \
+    .dotclk_hz = hz, .clkdiv = (uint32_t) (SYSTEM_CLOCK_HZ * 256.0 / (2 * (hz))),                                      \
+    .char_rate = (uint32_t) ((hz) / 8 / MHZ * 65536)
+// The assembly loops (video_fetch.S) only exist in VIDEO_FETCH_ASM firmware
+#if VIDEO_FETCH_ASM
+#define FETCH_LOOP(loop_) .loop = loop_,
+#else
+#define FETCH_LOOP(loop_)
+#endif
+
+const video_mode_desc_t video_mode_registry[VIDEO_MODE_COUNT] = {
+    [VIDEO_MODE_TEXT_80x25] = {
+        .name = "text 80x25",
+        .crtc = mc6845_cga_80x25,
+        DOTCLK(CLOCK_FREQ_TEXT),
+        .fetch = video_fetch_text,
+        FETCH_LOOP(video_fetch_loop_text)
+        TEXT_ROWS_GEOMETRY,
+        .mode_control = CGA_MODE_VALUE_80x25,
+    },
+    [VIDEO_MODE_TEXT_40x25] = {
+        .name = "text 40x25",
+        .crtc = mc6845_cga_40x25,
+        DOTCLK(CLOCK_FREQ_GRAPHICS),
+        .fetch = video_fetch_text,
+        FETCH_LOOP(video_fetch_loop_text)
+        TEXT_ROWS_GEOMETRY,
+        .mode_control = CGA_MODE_VALUE_40x25,
+    },
+    [VIDEO_MODE_GRAPHICS] = {
+        .name = "graphics 320x200",
+        .crtc = mc6845_cga_320x200,
+        DOTCLK(CLOCK_FREQ_GRAPHICS),
+        .fetch = video_fetch_graphics,
+        FETCH_LOOP(video_fetch_loop_graphics)
+        GRAPHICS_GEOMETRY,
+        .mode_control = CGA_MODE_VALUE_320x200,
+    },
+    [VIDEO_MODE_GRAPHICS_640] = {
+        .name = "graphics 640x200",
+        .crtc = mc6845_cga_640x200,
+        DOTCLK(CLOCK_FREQ_TEXT),
+        .fetch = video_fetch_graphics,
+        FETCH_LOOP(video_fetch_loop_graphics)
+        GRAPHICS_GEOMETRY,
+        .mode_control = CGA_MODE_VALUE_640x200,
+    },
+    // Cells in the graphics window, pairs in tweak_cells: 13 MA bits, no RA
+    [VIDEO_MODE_TEXT_160x100] = {
+        .name = "text 160x100",
+        .crtc = mc6845_cga_160x100,
+        DOTCLK(CLOCK_FREQ_TEXT),
+        .fetch = video_fetch_tweak,
+        FETCH_LOOP(video_fetch_loop_tweak)
+        GEOMETRY(VIDEO_LAYOUT_TWEAK),
+        .window = VIDEO_WINDOW_GRAPHICS,
+        .mode_control = CGA_MODE_VALUE_160x100,
+    },
+};
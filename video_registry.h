@@ -0,0 +1,49 @@
+#pragma once
+
+// Video mode descriptors: everything that differs between modes, one const entry per
+// video_mode_t. A mode switch activates an entry as a whole: core 0 loads its CRTC
+// table, core 1 sets its DOTCLK and takes its fetch kernel, DMA layout and window in
+// the blank (main.c). A new mode, or new timings for an old one, is a new entry; the
+// fetch loop only ever calls the kernel it was handed.
+// cga_sim modes checks every entry against the CRTC model (host/mode_check.c).
+
+#include <stdint.h>
+
+#include "video_memory.h"
+#include "video_modes.h"
+
+typedef uint16_t (*video_fetch_kernel_t)(const void *table, uint32_t sample);
+
+typedef struct {
+    const char *name;
+    const uint8_t *crtc;        // R0-R15, loaded whole on a switch
+    float dotclk_hz;            // What the clock program generates; CHARCLK is 1/8 of it
+    uint32_t clkdiv;            // dotclk_hz as the clock SM's 16.8 divider at SYSTEM_CLOCK_HZ
+    uint32_t char_rate;         // CHARCLKs per us, 16.16, for the raster anchor
+    video_fetch_kernel_t fetch; // CPU fetch loop (VIDEO_FETCH_DMA 0), on the page's table
+#if VIDEO_FETCH_ASM
+    video_fetch_loop_t loop; // Instead, the same lookup as video_fetch.S
+#endif
+    // Buffer geometry: page 0 of the table the fetch reads, the page stride, and the
+    // DMA chain's index widths over it (video_dma_layout_t)
+    const void *table;
+    uint32_t page_bytes;
+    uint8_t ma_bits, row_bits, entry_shift;
+    video_window_t window;      // What B8000h and the upload windows show of the mode
+    // PLD control lines: the 3D8h value the board latch needs for the mode (GRAPHICS
+    // enables graphics.pld, HIRES graphics640.pld, 80COL the full DOTCLK in
+    // clock-divider.pld). What the console keys write; a program writes its own.
+    uint8_t mode_control;
+} video_mode_desc_t;
+
+extern const video_mode_desc_t video_mode_registry[VIDEO_MODE_COUNT];
+
+static inline const video_mode_desc_t *video_mode_desc(const video_mode_t mode) {
+    return &video_mode_registry[mode];
+}
+
+// Flipping pages is swapping the table base the DMA chain reads from
+static inline video_dma_layout_t video_mode_layout(const video_mode_desc_t *mode, const uint8_t page) {
+    return (video_dma_layout_t) {(const uint8_t *) mode->table + page * mode->page_bytes, mode->ma_bits,
+                                 mode->row_bits, mode->entry_shift};
+}